@@ -0,0 +1,57 @@
+#pragma once
+
+#define AFFINITY_SET_SIZE 8     /*processes whose working set a core is assumed to still hold*/
+
+/*the processes that ran on a core most recently, most recent first. A process still in the set
+is taken to have its working set in the cache of the core, one that was pushed out by
+AFFINITY_SET_SIZE other processes is not. The set is a small fixed array, so looking a process
+up and moving it to the front costs the same however many threads or cores there are.
+The old switch model is this set with a single entry*/
+class AffinitySet
+{
+public:
+	AffinitySet()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		count = 0;
+	}
+
+	/*moves process to the front, adding it and dropping the least recent one if it is not
+	in the set. Returns true if it was in the set*/
+	bool touch(int process)
+	{
+		int i = 0;
+
+		while (i < count && entries[i] != process)
+		{
+			i++;
+		}
+
+		bool found = i < count;
+		if (!found)
+		{
+			i = (count < AFFINITY_SET_SIZE) ? count++ : AFFINITY_SET_SIZE - 1;
+		}
+
+		for (; i > 0; i--)
+		{
+			entries[i] = entries[i - 1];
+		}
+		entries[0] = process;
+
+		return found;
+	}
+
+	int size()
+	{
+		return count;
+	}
+
+private:
+	int entries[AFFINITY_SET_SIZE];     /*process indices, most recent first*/
+	int count;
+};
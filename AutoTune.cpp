@@ -0,0 +1,297 @@
+#include "AutoTune.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+/*index of the 99th percentile in n sorted values (nearest rank)*/
+static size_t p99Index(size_t n)
+{
+	size_t rank = (n * 99 + 99) / 100;
+
+	return rank > 0 ? rank - 1 : 0;
+}
+
+/*value of the objective for a finished run*/
+float tuneScore(const SimResults & results, TuneObjective objective)
+{
+	if (objective == TUNE_AVERAGE)
+	{
+		return results.average_turnaround;
+	}
+
+	std::vector<int> turnaround;
+	turnaround.reserve(results.threads.size());
+	for (const ThreadResult & r : results.threads)
+	{
+		turnaround.push_back(r.turnaround_time);
+	}
+	if (turnaround.empty())
+	{
+		return 0;
+	}
+
+	size_t k = p99Index(turnaround.size());
+	std::nth_element(turnaround.begin(), turnaround.begin() + k, turnaround.end());
+	return (float)turnaround[k];
+}
+
+/*lower bound on the final objective value of a run in progress, a thread that has not exited
+yet will exit no earlier than now, so its turnaround is at least clock - arrival*/
+float tuneLowerBound(CPUSim & cpu, TuneObjective objective)
+{
+	if (objective == TUNE_AVERAGE)
+	{
+		/*averageTurnaround() takes, per process, the turnaround of its last thread to exit*/
+		int num_of_processes = cpu.process_table.size();
+		std::vector<int> last_exit(num_of_processes, -1);
+		std::vector<int> last_turnaround(num_of_processes, 0);
+		std::vector<int> pending_arrival(num_of_processes, -1);
+		float turnaround = 0;
+
+		for (auto & t : cpu.threads)
+		{
+			int p = t->getProcessIndex();
+			if (p < 0 || p >= num_of_processes)
+			{
+				continue;
+			}
+			if (t->getExitTime() == DEFAULT_EXIT_VALUE)
+			{
+				pending_arrival[p] = std::max(pending_arrival[p], t->getArrivalTime());
+			}
+			else if (t->getExitTime() > last_exit[p])
+			{
+				last_exit[p] = t->getExitTime();
+				last_turnaround[p] = t->getExitTime() - t->getArrivalTime();
+			}
+		}
+
+		for (int p = 0; p < num_of_processes; p++)
+		{
+			if (pending_arrival[p] >= 0)
+			{
+				turnaround += std::max(0, cpu.clock - pending_arrival[p]);
+			}
+			else
+			{
+				turnaround += last_turnaround[p];
+			}
+		}
+		return turnaround / std::max(cpu.num_of_processes, num_of_processes);
+	}
+
+	std::vector<int> turnaround;
+	turnaround.reserve(cpu.threads.size());
+	for (auto & t : cpu.threads)
+	{
+		if (t->getExitTime() == DEFAULT_EXIT_VALUE)
+		{
+			turnaround.push_back(std::max(0, cpu.clock - t->getArrivalTime()));
+		}
+		else
+		{
+			turnaround.push_back(t->getExitTime() - t->getArrivalTime());
+		}
+	}
+	if (turnaround.empty())
+	{
+		return 0;
+	}
+
+	size_t k = p99Index(turnaround.size());
+	std::nth_element(turnaround.begin(), turnaround.begin() + k, turnaround.end());
+	return (float)turnaround[k];
+}
+
+/*lowers best to score if score is better*/
+static void updateBest(std::atomic<float> & best, float score)
+{
+	float current = best.load();
+
+	while (score < current && !best.compare_exchange_weak(current, score))
+	{
+	}
+}
+
+/*runs one quantum to completion, or until it can no longer beat best*/
+static TunePoint evaluate(CPUSim & cpu, const Workload & workload, int quantum, TuneObjective objective, std::atomic<float> & best)
+{
+	RunConfig config;
+	TunePoint point;
+	long long check_ticks = std::max<long long>(TUNE_CHECK_TICKS, workload.getNumberOfThreads());
+	long long ticks = 0;
+
+	config.round_robin = SET;
+	config.time_quantum = quantum;
+	cpu.configure(config);
+	cpu.load(workload);
+
+	point.time_quantum = quantum;
+	point.abandoned = false;
+
+	while (cpu.step())
+	{
+		/*checking costs a pass over all threads, so it is only done every check_ticks ticks*/
+		if (++ticks % check_ticks == 0)
+		{
+			float bound = tuneLowerBound(cpu, objective);
+			if (bound > best.load())
+			{
+				point.abandoned = true;
+				point.score = bound;
+				return point;
+			}
+		}
+	}
+
+	point.score = tuneScore(cpu.getResults(), objective);
+	updateBest(best, point.score);
+	return point;
+}
+
+/*searches for the RR time quantum minimizing the objective*/
+TuneResult autotune(const Workload & workload, const TuneOptions & options)
+{
+	std::map<int, TunePoint> evaluated;
+	std::atomic<float> best(1e30f);
+	int lo = std::max(options.min_quantum, MIN_RR_QUANTUM);
+	int hi = options.max_quantum;
+	int num_workers = options.num_workers;
+	TuneResult result;
+
+	result.default_max = 0;
+
+	/*past the longest cpu burst every quantum behaves the same*/
+	if (hi <= 0)
+	{
+		hi = lo;
+		for (const ThreadSpec & spec : workload.threads)
+		{
+			/*the bursts of a program are only known once it runs*/
+			if (spec.program != nullptr && result.default_max == 0)
+			{
+				result.default_max = PROGRAM_TUNE_MAX;
+				hi = std::max(hi, PROGRAM_TUNE_MAX);
+			}
+			if (spec.generator.getCount() > 0)
+			{
+				hi = std::max(hi, spec.generator.getMaxCPUTime() + 1);
+			}
+			for (BurstCursor cursor = spec.encoded; cursor.hasNext();)
+			{
+				hi = std::max(hi, cursor.next().get_cpu_time() + 1);
+			}
+			for (Burst burst : spec.bursts)
+			{
+				hi = std::max(hi, burst.get_cpu_time() + 1);
+			}
+		}
+	}
+	hi = std::max(hi, lo);
+
+	if (num_workers <= 0)
+	{
+		num_workers = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	while (true)
+	{
+		int step = std::max(1, (hi - lo) / (TUNE_POINTS_PER_ROUND - 1));
+		std::vector<int> quanta;
+
+		for (int q = lo; q <= hi; q += step)
+		{
+			if (evaluated.find(q) == evaluated.end())
+			{
+				quanta.push_back(q);
+			}
+		}
+		if (evaluated.find(hi) == evaluated.end() && (quanta.empty() || quanta.back() != hi))
+		{
+			quanta.push_back(hi);
+		}
+
+		/*the quanta of a round are shared out between the workers*/
+		std::vector<TunePoint> points(quanta.size());
+		std::atomic<size_t> next(0);
+		std::vector<std::thread> workers;
+		int round_workers = std::min<int>(num_workers, (int)quanta.size());
+
+		for (int w = 0; w < round_workers; w++)
+		{
+			workers.emplace_back([&]()
+			{
+				CPUSim cpu;
+				size_t i;
+				while ((i = next++) < quanta.size())
+				{
+					points[i] = evaluate(cpu, workload, quanta[i], options.objective, best);
+				}
+			});
+		}
+		for (std::thread & worker : workers)
+		{
+			worker.join();
+		}
+		for (const TunePoint & point : points)
+		{
+			evaluated[point.time_quantum] = point;
+		}
+
+		/*best quantum so far, lowest quantum wins a tie*/
+		int best_quantum = lo;
+		float best_score = 1e30f;
+		for (auto & entry : evaluated)
+		{
+			if (!entry.second.abandoned && entry.second.score < best_score)
+			{
+				best_quantum = entry.first;
+				best_score = entry.second.score;
+			}
+		}
+		result.best_quantum = best_quantum;
+		result.best_score = best_score;
+
+		if (step == 1)
+		{
+			break;
+		}
+
+		/*narrow the range to the neighbours of the best quantum*/
+		lo = std::max(lo, best_quantum - step);
+		hi = std::min(hi, best_quantum + step);
+	}
+
+	for (auto & entry : evaluated)
+	{
+		result.curve.push_back(entry.second);
+	}
+
+	return result;
+}
+
+/*prints the best quantum and the evaluated curve*/
+void printTuneResult(const TuneResult & result, TuneObjective objective)
+{
+	const char * name = (objective == TUNE_AVERAGE) ? "Average Turnaround" : "p99 Turnaround";
+
+	printf("\nRound Robin autotune (minimizing %s):\n\n", name);
+	if (result.default_max > 0)
+	{
+		printf("The workload has program threads, so quanta up to %d were searched.\nUse --tune-range to search a different range.\n\n", result.default_max);
+	}
+	printf("quantum\t%s\n", name);
+	for (const TunePoint & point : result.curve)
+	{
+		if (point.abandoned)
+		{
+			printf("%d\t> %.1f (abandoned)\n", point.time_quantum, point.score);
+		}
+		else
+		{
+			printf("%d\t%.1f%s\n", point.time_quantum, point.score, point.time_quantum == result.best_quantum ? "\t<- best" : "");
+		}
+	}
+	printf("\nBest time quantum is %d (%s %.1f time units)\n\n", result.best_quantum, name, result.best_score);
+}
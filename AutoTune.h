@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CPUSim.h"
+#include <vector>
+
+#define TUNE_POINTS_PER_ROUND 16    /*quanta tried per coarse-to-fine round*/
+#define TUNE_CHECK_TICKS 4096       /*ticks between checks whether a run can be abandoned*/
+#define PROGRAM_TUNE_MAX 1000       /*highest quantum searched by default when program threads make the longest cpu burst unknown*/
+
+/*what the tuner minimizes*/
+typedef enum TuneObjective {
+	TUNE_AVERAGE = 0,       /*average turnaround as reported by printDefaultStats*/
+	TUNE_P99 = 1            /*99th percentile of per thread turnaround*/
+} TuneObjective;
+
+struct TuneOptions
+{
+	TuneOptions()
+	{
+		objective = TUNE_AVERAGE;
+		min_quantum = MIN_RR_QUANTUM;
+		max_quantum = 0;
+		num_workers = 0;
+	}
+
+	TuneObjective objective;
+	int min_quantum;
+	int max_quantum;            /*0 to stop where RR turns into FCFS (longest cpu burst + 1),
+	                            or at PROGRAM_TUNE_MAX if the workload has program threads*/
+	int num_workers;            /*0 for one worker per hardware thread*/
+};
+
+/*one evaluated quantum*/
+struct TunePoint
+{
+	int time_quantum;
+	float score;                /*objective value, or the bound that got the run abandoned*/
+	bool abandoned;             /*run was stopped once it could no longer beat the best*/
+};
+
+struct TuneResult
+{
+	int best_quantum;
+	float best_score;
+	std::vector<TunePoint> curve;   /*every quantum evaluated, by increasing quantum*/
+	int default_max;                /*PROGRAM_TUNE_MAX if it was used as the upper bound, else 0*/
+};
+
+/*searches for the RR time quantum minimizing the objective. Each round runs a spread of
+quanta in parallel and narrows the range around the best one until neighbouring quanta
+are 1 apart. Runs are abandoned as soon as a lower bound on their final score exceeds
+the best score found so far*/
+TuneResult autotune(const Workload & workload, const TuneOptions & options);
+
+/*value of the objective for a finished run*/
+float tuneScore(const SimResults & results, TuneObjective objective);
+
+/*lower bound on the final objective value of a run in progress*/
+float tuneLowerBound(CPUSim & cpu, TuneObjective objective);
+
+/*prints the best quantum and the evaluated curve*/
+void printTuneResult(const TuneResult & result, TuneObjective objective);
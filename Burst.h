@@ -2,15 +2,18 @@
 
 #include <iostream>
 
+#define MIN_CPU_BURST 2     /*shortest cpu burst the simulator can execute, a burst of 1 never finishes*/
+
 /*the BurstNode type holds a pair of bursts (1 io, and 1 cpu) on the execution stack (BurstQueue)*/
 
 class Burst
 {
 public:
-	Burst(int cpu_t, int io_t)
+	Burst(int cpu_t, int io_t, int io_device = 0)
 	{
 		cpu_time = cpu_t;
 		io_time = io_t;
+		device = io_device;
 	}
 	int get_cpu_time()
 	{
@@ -20,6 +23,10 @@ public:
 	{
 		return io_time;
 	}
+	int get_device()
+	{
+		return device;
+	}
 	void display()
 	{
 		std::cout << "\tcpu: " << cpu_time << " \t io: " << io_time << " " << std::endl;
@@ -27,4 +34,5 @@ public:
 private:
 	int cpu_time;               /*holds the length of a cpu burst on the execution stack*/
 	int io_time;                /*holds length of an io burst on the execution stack*/
+	int device;                 /*io device the io burst is served by*/
 };
\ No newline at end of file
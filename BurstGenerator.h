@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Burst.h"
+#include <math.h>
+#include <stdint.h>
+
+/*how the lengths of generated bursts are drawn*/
+typedef enum Distribution {
+	DIST_FIXED = 0,         /*always a*/
+	DIST_UNIFORM = 1,       /*uniform in [a, b]*/
+	DIST_EXPONENTIAL = 2    /*exponential with mean a, never below b*/
+} Distribution;
+
+struct BurstDistribution
+{
+	Distribution type;
+	int a;
+	int b;
+};
+
+/*describes the bursts of a thread as a distribution, a seed and a count instead of a list.
+Bursts are drawn one at a time as the thread asks for them, so a thread costs the same
+memory whatever its number of bursts, and the same seed always gives the same bursts*/
+class BurstGenerator
+{
+public:
+	BurstGenerator()
+	{
+		cpu.type = DIST_FIXED;
+		cpu.a = cpu.b = 0;
+		io = cpu;
+		state = 0;
+		count = 0;
+		generated = 0;
+	}
+
+	BurstGenerator(BurstDistribution cpu_dist, BurstDistribution io_dist, uint64_t seed, int num_of_bursts)
+	{
+		cpu = cpu_dist;
+		io = io_dist;
+		state = seed;
+		count = num_of_bursts;
+		generated = 0;
+	}
+
+	bool hasNext()
+	{
+		return generated < count;
+	}
+
+	/*draws the next cpu-io pair, the last pair has an io time of -1*/
+	Burst next()
+	{
+		int cpu_t = draw(cpu);
+		int io_t = draw(io);
+
+		if (cpu_t < MIN_CPU_BURST)
+		{
+			cpu_t = MIN_CPU_BURST;
+		}
+		if (io_t < 0)
+		{
+			io_t = 0;
+		}
+
+		generated++;
+		return Burst(cpu_t, generated == count ? -1 : io_t);
+	}
+
+	int getCount() const
+	{
+		return count;
+	}
+
+	BurstDistribution getCPUDistribution() const
+	{
+		return cpu;
+	}
+
+	BurstDistribution getIODistribution() const
+	{
+		return io;
+	}
+
+	/*random state, equal to the seed until the first burst is drawn*/
+	uint64_t getState() const
+	{
+		return state;
+	}
+
+	/*longest cpu burst the generator is expected to produce (10 means for exponential)*/
+	int getMaxCPUTime() const
+	{
+		if (cpu.type == DIST_UNIFORM)
+		{
+			return cpu.b;
+		}
+		if (cpu.type == DIST_EXPONENTIAL)
+		{
+			return cpu.a * 10;
+		}
+		return cpu.a;
+	}
+
+private:
+	/*splitmix64, 8 bytes of state and good enough for workload synthesis*/
+	uint64_t random()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	int draw(BurstDistribution & d)
+	{
+		if (d.type == DIST_UNIFORM)
+		{
+			uint64_t span = (uint64_t)(d.b - d.a) + 1;
+			return d.a + (int)(random() % span);
+		}
+		if (d.type == DIST_EXPONENTIAL)
+		{
+			double u = (random() >> 11) * (1.0 / 9007199254740992.0);
+			int t = (int)(-d.a * log(1.0 - u) + 0.5);
+			return t < d.b ? d.b : t;
+		}
+		return d.a;
+	}
+
+	BurstDistribution cpu;      /*distribution of cpu burst lengths*/
+	BurstDistribution io;       /*distribution of io burst lengths*/
+	uint64_t state;             /*random state, starts as the seed*/
+	int count;                  /*number of cpu-io pairs to generate*/
+	int generated;              /*pairs generated so far*/
+};
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Burst.h"
+#include <coroutine>
+#include <exception>
+#include <stddef.h>
+
+#define FRAME_CLASS_BYTES 64            /*coroutine frames are pooled in multiples of this size*/
+#define FRAME_CLASSES 64                /*frames above FRAME_CLASSES * FRAME_CLASS_BYTES use operator new*/
+#define FRAME_SLAB_BYTES (1 << 16)      /*bytes the pool takes from operator new at a time*/
+
+/*what a programmable thread can see of its own run, updated by the simulator
+right before the thread is resumed for its next burst*/
+struct ProgramContext
+{
+	int clock;                  /*time the burst is about to start*/
+	int last_wait;              /*time spent in the ready queue before this dispatch*/
+	int bursts_done;            /*bursts yielded so far*/
+	int process_number;
+	int thread_number;
+};
+
+/*per host thread free lists of coroutine frames, one list per size class.
+Frames of a coroutine function all have the same size, so after the first few
+threads every frame is reused from a list instead of calling operator new.
+Slabs are never handed back, they are reused for as long as the process runs*/
+class FramePool
+{
+public:
+	static void * allocate(size_t n)
+	{
+		size_t c = (n + FRAME_CLASS_BYTES - 1) / FRAME_CLASS_BYTES;
+
+		if (c >= FRAME_CLASSES)
+		{
+			return ::operator new(n);
+		}
+
+		FreeFrame *& head = lists().head[c];
+		if (head == nullptr)
+		{
+			refill(c);
+		}
+		FreeFrame * frame = head;
+		head = frame->next;
+		return frame;
+	}
+
+	static void release(void * p, size_t n)
+	{
+		size_t c = (n + FRAME_CLASS_BYTES - 1) / FRAME_CLASS_BYTES;
+
+		if (c >= FRAME_CLASSES)
+		{
+			::operator delete(p);
+			return;
+		}
+
+		FreeFrame * frame = (FreeFrame *)p;
+		frame->next = lists().head[c];
+		lists().head[c] = frame;
+	}
+
+private:
+	struct FreeFrame
+	{
+		FreeFrame * next;
+	};
+
+	struct FreeLists
+	{
+		FreeFrame * head[FRAME_CLASSES] = {};
+	};
+
+	static FreeLists & lists()
+	{
+		static thread_local FreeLists free_lists;
+		return free_lists;
+	}
+
+	/*carves a new slab into frames of class c*/
+	static void refill(size_t c)
+	{
+		size_t size = c * FRAME_CLASS_BYTES;
+		size_t count = FRAME_SLAB_BYTES / size;
+		char * slab = (char *)::operator new(size * count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			release(slab + i * size, size);
+		}
+	}
+};
+
+/*coroutine type of a programmable thread. The coroutine co_yields one Burst per cpu-io
+pair, with an io time of -1 on its last burst, and is only resumed when the simulator
+needs the next burst of the thread (see Thread::setTimings). For example:
+
+	BurstProgram adaptive(ProgramContext & ctx, long long arg)
+	{
+		for (int i = 0; i < arg - 1; i++)
+		{
+			co_yield Burst(ctx.last_wait > 100 ? 5 : 50, 20);
+		}
+		co_yield Burst(10, -1);
+	}
+*/
+class BurstProgram
+{
+public:
+	struct promise_type
+	{
+		Burst current = Burst(MIN_CPU_BURST, -1);
+
+		BurstProgram get_return_object()
+		{
+			return BurstProgram(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		/*nothing runs until the first burst is needed*/
+		std::suspend_always initial_suspend()
+		{
+			return {};
+		}
+
+		std::suspend_always final_suspend() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_always yield_value(Burst burst)
+		{
+			current = burst;
+			return {};
+		}
+
+		void return_void()
+		{
+		}
+
+		void unhandled_exception()
+		{
+			std::terminate();
+		}
+
+		static void * operator new(size_t n)
+		{
+			return FramePool::allocate(n);
+		}
+
+		static void operator delete(void * p, size_t n)
+		{
+			FramePool::release(p, n);
+		}
+	};
+
+	BurstProgram()
+	{
+		handle = nullptr;
+	}
+
+	explicit BurstProgram(std::coroutine_handle<promise_type> h)
+	{
+		handle = h;
+	}
+
+	BurstProgram(BurstProgram && other) noexcept
+	{
+		handle = other.handle;
+		other.handle = nullptr;
+	}
+
+	BurstProgram & operator=(BurstProgram && other) noexcept
+	{
+		if (this != &other)
+		{
+			destroy();
+			handle = other.handle;
+			other.handle = nullptr;
+		}
+		return *this;
+	}
+
+	BurstProgram(const BurstProgram &) = delete;
+	BurstProgram & operator=(const BurstProgram &) = delete;
+
+	~BurstProgram()
+	{
+		destroy();
+	}
+
+	/*true while the coroutine may still produce bursts*/
+	bool isActive()
+	{
+		return handle && !handle.done();
+	}
+
+	/*resumes the coroutine for its next burst. A coroutine that returns without
+	yielding one gets a minimal last burst, so the thread still exits*/
+	Burst next()
+	{
+		handle.resume();
+		if (handle.done())
+		{
+			return Burst(MIN_CPU_BURST, -1);
+		}
+
+		Burst burst = handle.promise().current;
+		if (burst.get_cpu_time() < MIN_CPU_BURST)
+		{
+			burst = Burst(MIN_CPU_BURST, burst.get_io_time());
+		}
+		return burst;
+	}
+
+private:
+	void destroy()
+	{
+		if (handle)
+		{
+			handle.destroy();
+			handle = nullptr;
+		}
+	}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+/*creates the coroutine of one programmable thread, arg is passed through from the workload*/
+typedef BurstProgram (*ProgramFactory)(ProgramContext & ctx, long long arg);
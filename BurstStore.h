@@ -0,0 +1,272 @@
+#pragma once
+
+#include "Burst.h"
+#include <algorithm>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#define BURST_STORE_CHUNK (1 << 22)     /*bytes per arena chunk of the store*/
+
+/*reads the bursts of one thread back out of a BurstStore, strictly in order.
+The bursts of a thread are one or more segments, each the varint count of its bursts
+followed by the bursts. Each burst is stored as the zigzag varint of the difference of its
+cpu time and of its io time to those of the burst before it in the segment, so a cursor only
+needs the previous pair. The io value carries one more low bit, set when the io device differs
+from the one of the burst before, in which case the zigzag varint of the new device follows.
+A segment that is not the last one of its thread is followed by the address of the next*/
+class BurstCursor
+{
+public:
+	BurstCursor()
+	{
+		data = nullptr;
+		count = 0;
+		remaining = 0;
+		cpu = 0;
+		io = 0;
+		device = 0;
+	}
+
+	BurstCursor(const uint8_t * encoded, int num_of_bursts)
+	{
+		data = encoded;
+		count = num_of_bursts;
+		remaining = num_of_bursts;
+		in_segment = (num_of_bursts > 0) ? (int)decode() : 0;
+		cpu = 0;
+		io = 0;
+		device = 0;
+	}
+
+	bool hasNext()
+	{
+		return remaining > 0;
+	}
+
+	Burst next()
+	{
+		/*the segment is done but the thread is not, the next segment is linked in*/
+		if (in_segment == 0)
+		{
+			memcpy(&data, data, sizeof(data));
+			in_segment = (int)decode();
+			cpu = 0;
+			io = 0;
+			device = 0;
+		}
+
+		cpu += unzigzag(decode());
+		uint64_t value = decode();
+		io += unzigzag(value >> 1);
+		if (value & 1)
+		{
+			device = unzigzag(decode());
+		}
+		in_segment--;
+		remaining--;
+		return Burst(cpu, io, device);
+	}
+
+	int getCount() const
+	{
+		return count;
+	}
+
+private:
+	uint64_t decode()
+	{
+		uint64_t value = 0;
+		int shift = 0;
+		uint8_t byte;
+
+		do
+		{
+			byte = *data++;
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+
+		return value;
+	}
+
+	/*undoes the zigzag mapping*/
+	static int unzigzag(uint64_t value)
+	{
+		return (int)(uint32_t)(value >> 1) ^ -(int)(value & 1);
+	}
+
+	const uint8_t * data;       /*next encoded byte*/
+	int count;                  /*bursts encoded for the thread*/
+	int remaining;              /*bursts not decoded yet*/
+	int in_segment;             /*bursts not decoded yet in the current segment*/
+	int cpu;                    /*last decoded cpu time*/
+	int io;                     /*last decoded io time*/
+	int device;                 /*last decoded io device*/
+};
+
+/*append only arena holding the delta/zigzag/varint encoded bursts of many threads.
+The bursts of a thread are encoded as one segment, or a chain of them for a thread added a
+part at a time, that never straddles two chunks, so a cursor is just a pointer and a count,
+and the arena grows a chunk at a time without ever copying what is already stored*/
+class BurstStore
+{
+public:
+	BurstStore()
+	{
+		used = 0;
+		capacity = 0;
+		bytes = 0;
+	}
+
+	/*encodes the bursts of one thread and returns a cursor at the first of them*/
+	BurstCursor add(const std::vector<Burst> & bursts)
+	{
+		return BurstCursor(addSegment(bursts, nullptr, nullptr), (int)bursts.size());
+	}
+
+	/*encodes bursts as a segment and returns it. If link is set, the address of the segment is
+	written there. If next_link is set, room for the address of the segment that follows is left
+	after this one and next_link points at it*/
+	const uint8_t * addSegment(const std::vector<Burst> & bursts, uint8_t * link, uint8_t ** next_link)
+	{
+		int cpu = 0;
+		int io = 0;
+		int device = 0;
+
+		scratch.clear();
+		encode(bursts.size());
+		for (Burst burst : bursts)
+		{
+			bool device_changed = burst.get_device() != device;
+
+			encode(zigzag(burst.get_cpu_time() - cpu));
+			encode((zigzag(burst.get_io_time() - io) << 1) | (device_changed ? 1 : 0));
+			if (device_changed)
+			{
+				encode(zigzag(burst.get_device()));
+			}
+			cpu = burst.get_cpu_time();
+			io = burst.get_io_time();
+			device = burst.get_device();
+		}
+		if (next_link != nullptr)
+		{
+			scratch.resize(scratch.size() + sizeof(uint8_t *));
+		}
+
+		/*start a new chunk when the block does not fit, big blocks get a chunk of their own*/
+		if (used + scratch.size() > capacity)
+		{
+			capacity = scratch.size() > BURST_STORE_CHUNK ? scratch.size() : BURST_STORE_CHUNK;
+			chunks.emplace_back(new uint8_t[capacity]);
+			used = 0;
+		}
+
+		uint8_t * block = chunks.back().get() + used;
+		std::copy(scratch.begin(), scratch.end(), block);
+		used += scratch.size();
+		bytes += scratch.size();
+
+		if (link != nullptr)
+		{
+			memcpy(link, &block, sizeof(block));
+		}
+		if (next_link != nullptr)
+		{
+			*next_link = block + scratch.size() - sizeof(uint8_t *);
+		}
+		return block;
+	}
+
+	/*takes over every chunk of other, cursors into other stay valid*/
+	void absorb(BurstStore & other)
+	{
+		if (other.chunks.empty())
+		{
+			return;
+		}
+
+		for (auto & chunk : other.chunks)
+		{
+			chunks.push_back(std::move(chunk));
+		}
+		used = other.used;
+		capacity = other.capacity;
+		bytes += other.bytes;
+
+		other.chunks.clear();
+		other.used = 0;
+		other.capacity = 0;
+		other.bytes = 0;
+	}
+
+	/*bytes of encoded bursts held by the store*/
+	size_t getBytes()
+	{
+		return bytes;
+	}
+
+private:
+	/*zigzag maps small negative and positive deltas to small unsigned values*/
+	static uint64_t zigzag(int delta)
+	{
+		return ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+	}
+
+	void encode(uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			scratch.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		scratch.push_back((uint8_t)value);
+	}
+
+	std::vector<std::unique_ptr<uint8_t[]>> chunks;
+	size_t used;                /*bytes used in the last chunk*/
+	size_t capacity;            /*size of the last chunk*/
+	size_t bytes;               /*encoded bytes over all chunks*/
+	std::vector<uint8_t> scratch;   /*block being encoded*/
+};
+
+/*the compressed bursts of a thread whose bursts become known a part at a time, such as a long
+lived task of an imported trace, so they are never all held uncompressed at once*/
+class BurstChain
+{
+public:
+	BurstChain()
+	{
+		first = nullptr;
+		link = nullptr;
+		count = 0;
+	}
+
+	/*encodes bursts as the next segment of the thread, more is false for the last one*/
+	void add(BurstStore & store, const std::vector<Burst> & bursts, bool more)
+	{
+		const uint8_t * segment = store.addSegment(bursts, link, more ? &link : nullptr);
+
+		if (first == nullptr)
+		{
+			first = segment;
+		}
+		count += (int)bursts.size();
+		if (!more)
+		{
+			link = nullptr;
+		}
+	}
+
+	BurstCursor getCursor()
+	{
+		return BurstCursor(first, count);
+	}
+
+private:
+	const uint8_t * first;      /*first segment*/
+	uint8_t * link;             /*room for the address of the next segment*/
+	int count;                  /*bursts in all segments*/
+};
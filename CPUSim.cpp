@@ -1,4 +1,9 @@
 #include "CPUSim.h"
+#include "EventLog.h"
+#include "ResultsWriter.h"
+#include "Sampler.h"
+#include <algorithm>
+#include <climits>
 #include <sstream>
 #include <string>
 #include <memory>
@@ -6,49 +11,278 @@
 
 CPUSim::CPUSim()
 {
-	clock = 0;
-
-	mode = NEWCPU;
-
-	prev_process = -1;
-	wait = 0;
-	cpu_is_executing = 0;
-
 	detailed = UNSET;
 	verbose = UNSET;
 	round_robin = UNSET;
 	time_quantum = NO_QUANTUM_VALUE;
+	thread_switch_override = -1;
+	process_switch_override = -1;
+	affinity = UNSET;
+	warm_switch = 0;
+	cold_switch = 0;
+	migration_switch = 0;
 
-	total_cpu_execution_time = 0;
 	thread_switch = -1;
 	process_switch = -1;
 	num_of_threads = -1;
 	num_of_processes = -1;
+
+	results_out = nullptr;
+	sampler = nullptr;
+	event_log = nullptr;
+	io_devices.resize(1);
+	report_devices = false;
+
+	reset();
 }
 
-void CPUSim::addFinishedIOThreadsToReadyQueue()
+void CPUSim::configure(const RunConfig & config)
 {
-	std::shared_ptr<Thread> arriving_thread = nullptr;
+	verbose = config.verbose;
+	detailed = config.detailed;
+	round_robin = config.round_robin;
+	time_quantum = config.time_quantum;
+	thread_switch_override = config.thread_switch;
+	process_switch_override = config.process_switch;
+	affinity = config.affinity;
+	warm_switch = config.warm_switch;
+	cold_switch = config.cold_switch;
+	migration_switch = config.migration_switch;
+
+	/*without configured devices all io goes to one device with unlimited channels*/
+	io_devices.assign(std::max((size_t)1, config.io_devices.size()), IODevice());
+	for (size_t i = 0; i < config.io_devices.size(); i++)
+	{
+		io_devices[i].configure(config.io_devices[i]);
+	}
+	report_devices = !config.io_devices.empty();
+}
 
-	do
+void CPUSim::load(const Workload & workload)
+{
+	reset();
+
+	num_of_processes = workload.num_of_processes;
+	thread_switch = (thread_switch_override >= 0) ? thread_switch_override : workload.thread_switch;
+	process_switch = (process_switch_override >= 0) ? process_switch_override : workload.process_switch;
+	process_table = workload.processes;
+	store = workload.store;
+	process_switches.assign(workload.processes.size(), 0);
+
+	/*every thread described by the workload starts out in the job queue*/
+	threads.reserve(workload.threads.size());
+	for (const ThreadSpec & spec : workload.threads)
 	{
-		/*removes a thread from IO queue which has no IO time left*/
-		arriving_thread = io_queue.removeIOThreadAtTime(IO_COMPLETED);
+		admit(spec);
+	}
 
-		/*if thread is NULL, that means there are none with that time, we skip this if*/
-		if (arriving_thread != nullptr)
+	/*the ready queue never holds more than every thread, so it will not grow during the run*/
+	ready_queue.reserve(threads.size());
+
+	num_of_threads = job_queue.size();
+}
+
+void CPUSim::admit(const ThreadSpec & spec, bool migrated)
+{
+	threads.push_back(std::make_shared<Thread>(spec));
+	threads.back()->setIndex((int)threads.size() - 1);
+	threads.back()->setMigrated(migrated);
+	addThread(threads.back(), JOB);
+
+	/*a finished run continues once a thread is admitted*/
+	num_of_threads = (int)threads.size();
+}
+
+void CPUSim::idleUntil(int time)
+{
+	if (!canContinue(exit_queue) && sampler == nullptr && clock < time)
+	{
+		clock = time;
+	}
+}
+
+void CPUSim::reset()
+{
+	clock = 0;
+
+	mode = NEWCPU;
+
+	prev_process = -1;
+	wait = 0;
+	cpu_is_executing = 0;
+
+	total_cpu_execution_time = 0;
+	context_switches = 0;
+	recent.clear();
+	warm_switches = 0;
+	cold_switches = 0;
+	migrated_switches = 0;
+	next_sample_time = (sampler != nullptr) ? sampler->getNextSampleTime() : INT_MAX;
+
+	current_thread = nullptr;
+	ready_queue.clear();
+	for (IODevice & device : io_devices)
+	{
+		device.clear();
+	}
+	job_queue.clear();
+	exit_queue.clear();
+	threads.clear();
+	process_switches.clear();
+}
+
+bool CPUSim::step()
+{
+	/*if there are no threads left to be worked on the run is over*/
+	if (!canContinue(exit_queue))
+	{
+		return false;
+	}
+
+	switch (mode)
+	{
+	case NEWCPU: /*CPU in NEWCPU upon initialization*/
+		setMode(DISPATCHING);
+		break;
+	case DISPATCHING:
+		/*if cpu dispatching, get the next thread to execute,
+		this function auto switches to either PSWITCH or
+		TSWITCH cpu mode based on the circumstanses*/
+		getNextThread();
+		break;
+	case EXECUTING:
+		/*executes a burst or loads in a new one if there is not one executing*/
+		/*function auto switches to dispatching once a thread is done its burst*/
+		executeThread(exit_queue);
+		break;
+	case PSWITCH:
+	case TSWITCH:
+		/*check to see when we can exit the context switch and begin executing*/
+		checkStatus();
+		break;
+	default:
+		printf("Fatal Error. Exiting\n");
+		exit(0);
+	}
+
+	/*move any arriving threads into ready queue*/
+	addArrivingIOThreadsToReadyQueue();
+	/*move any finished IO threads to ready queue*/
+	addFinishedIOThreadsToReadyQueue();
+
+	/*clock tick*/
+	advanceClock();
+
+	/*a sample covers the interval that just ended, no extra work happens between samples*/
+	if (clock >= next_sample_time)
+	{
+		sampler->sample(*this);
+		next_sample_time = sampler->getNextSampleTime();
+	}
+
+	return true;
+}
+
+SimResults CPUSim::run()
+{
+	while (step())
+	{
+	}
+
+	if (sampler != nullptr)
+	{
+		sampler->finish(*this);
+	}
+
+	return getResults();
+}
+
+void CPUSim::setSampler(Sampler * s)
+{
+	sampler = s;
+	next_sample_time = (sampler != nullptr) ? sampler->getNextSampleTime() : INT_MAX;
+}
+
+SimResults CPUSim::getResults()
+{
+	SimResults results;
+
+	results.time_quantum = time_quantum;
+	results.total_time = clock - 1; /*one extra clock tick upon exit, so removing it here*/
+
+	/*calculate cpu utilization*/
+	results.cpu_utilization = ((float)total_cpu_execution_time / results.total_time) * 100;
+
+	if (affinity == SET)
+	{
+		results.affinity = true;
+		results.warm_switches = warm_switches;
+		results.cold_switches = cold_switches;
+		results.migrated_switches = migrated_switches;
+		results.thread_switches = context_switches - warm_switches - cold_switches - migrated_switches;
+	}
+
+	if (report_devices)
+	{
+		for (const IODevice & device : io_devices)
+		{
+			DeviceResult d = makeDeviceResult(device.getConfig());
+			addToDeviceResult(d, device);
+			finishDeviceResult(d, results.total_time);
+			results.devices.push_back(d);
+		}
+	}
+
+	/*threads and processes in one pass over the exited threads*/
+	results.processes = makeProcessResults(process_table);
+	results.threads.reserve(exit_queue.size());
+	for (auto p : exit_queue.q)
+	{
+		results.threads.push_back(makeThreadResult(*p));
+
+		int process = p->getProcessIndex();
+		if (process >= 0 && process < (int)results.processes.size())
+		{
+			addToProcessResult(results.processes[process], results.threads.back());
+		}
+	}
+	for (size_t i = 0; i < results.processes.size() && i < process_switches.size(); i++)
+	{
+		results.processes[i].switches = process_switches[i];
+	}
+
+	results.average_turnaround = averageTurnaround(results.processes, num_of_processes);
+
+	return results;
+}
+
+void CPUSim::addFinishedIOThreadsToReadyQueue()
+{
+	while (true)
+	{
+		/*the device whose next completed burst comes first, a cpu blocks at most one thread
+		per tick so bursts on different devices never tie*/
+		IODevice * next = nullptr;
+		for (IODevice & device : io_devices)
 		{
-			if (verbose == SET)
+			if (device.completedBy(clock) && (next == nullptr || device.completesBefore(*next)))
 			{
-				/*if in verbose mode, print verbose description*/
-				std::cout << "At Time " << clock << ": Thread " << arriving_thread->getThreadNumber() << " of Process " << arriving_thread->getProcessNumber() << " moves from BLOCKED to READY" << std::endl;
+				next = &device;
 			}
+		}
 
-			/*take thread we removed from IO queue and add to Ready queue*/
-			addThread(arriving_thread, READY);
+		/*if there is none, every burst completed by now is ready*/
+		if (next == nullptr)
+		{
+			break;
 		}
-		/*if thread was null, nothing is done and loop is exited*/
-	} while (arriving_thread != nullptr);
+
+		int index = next->complete();
+		transition(*threads[index], STATE_BLOCKED, STATE_READY);
+
+		/*take thread we removed from its device and add to Ready queue*/
+		addThread(threads[index], READY);
+	}
 }
 
 void CPUSim::addArrivingIOThreadsToReadyQueue()
@@ -64,11 +298,8 @@ void CPUSim::addArrivingIOThreadsToReadyQueue()
 		/*if thread was not null, decrement size of job queue*/
 		if (arriving_thread != nullptr)
 		{
-			/*if verbose print as so*/
-			if (verbose == SET)
-			{
-				std::cout << "At Time " << clock << ": Thread " << arriving_thread->getThreadNumber() << " of Process " << arriving_thread->getProcessNumber() << " moves from NEW to READY" << std::endl;
-			}
+			/*if verbose print as so, and log it*/
+			transition(*arriving_thread, STATE_NEW, STATE_READY);
 
 			/*add arriving thread to ready queue*/
 			addThread(arriving_thread, READY);
@@ -81,12 +312,24 @@ void CPUSim::addThread(std::shared_ptr<Thread> thread, Destination dest)
 	/*mode enum signifies which queue to add to*/
 	if (dest == READY)
 	{
-		ready_queue.addThread(thread);
+		/*a thread that did not come from load() is added to the thread table first*/
+		if (thread->getIndex() < 0)
+		{
+			thread->setIndex((int)threads.size());
+			threads.push_back(thread);
+		}
+		thread->setReadyTime(clock);
+		ready_queue.push(thread->getIndex());
 	}
 
 	if (dest == IO)
 	{
-		io_queue.addThread(thread);
+		int device = thread->getIODevice();
+		if (device < 0 || device >= (int)io_devices.size())
+		{
+			device = 0;
+		}
+		io_devices[device].request(thread->getIndex(), thread->getIOTimeRemaining(), clock);
 	}
 
 	if (dest == JOB)
@@ -95,6 +338,17 @@ void CPUSim::addThread(std::shared_ptr<Thread> thread, Destination dest)
 	}
 }
 
+int CPUSim::getIODepth()
+{
+	int depth = 0;
+
+	for (IODevice & device : io_devices)
+	{
+		depth += device.size();
+	}
+	return depth;
+}
+
 bool CPUSim::canContinue(SimQueue & exit_queue)
 {
 	if (num_of_threads != exit_queue.size())
@@ -115,6 +369,7 @@ int CPUSim::executeThreadFCFS(SimQueue & q)
 	{
 		/*current thread set beforehand*/
 		/*set timings sets the length of the CPU and IO bursts to be executed right now*/
+		current_thread->setDispatchTime(clock);
 		current_thread->setTimings();
 		/*set the CPU wait to the length of the cpu burst*/
 		wait = current_thread->getCPUTime(); /*setting cpu to wait for length of cpu burst (ie do not execute any more threads)*/
@@ -132,11 +387,8 @@ int CPUSim::executeThreadFCFS(SimQueue & q)
 			current_thread->setIOThreadTotal(current_thread->getIOTimeRemaining() + current_thread->getIOThreadTotal());
 		}
 
-		/*verbose print*/
-		if (verbose == SET)
-		{
-			std::cout << "At Time " << clock << ": Thread " << current_thread->getThreadNumber() << " of Process " << current_thread->getProcessNumber() << " moves from READY to RUNNING" << std::endl;
-		}
+		/*verbose print and event log*/
+		transition(*current_thread, STATE_READY, STATE_RUNNING);
 
 		/*the cpu is now executing a burst so we chaning the cpu_is_executing to reflect that*/
 		cpu_is_executing = 1;
@@ -164,21 +416,21 @@ int CPUSim::executeThreadFCFS(SimQueue & q)
 				/*add to the queue that holds all exited threads (passed to this function)*/
 				q.addThread(current_thread);
 
-				/*verbose print*/
-				if (verbose == SET)
+				/*stream the finished thread to the results file, if one is open*/
+				if (results_out != nullptr)
 				{
-					std::cout << "At Time " << clock << ": Thread " << current_thread->getThreadNumber() << " of Process " << current_thread->getProcessNumber() << " moves from RUNNING to EXIT" << std::endl;
+					results_out->addThread(makeThreadResult(*current_thread));
 				}
+
+				/*verbose print and event log*/
+				transition(*current_thread, STATE_RUNNING, STATE_EXIT);
 			}
 			else
 			{
 				/*if not exiting, move the thread to the IO queue so it can do its IO time*/
-				if (verbose == SET)
-				{
-					std::cout << "At Time " << clock << ": Thread " << current_thread->getThreadNumber() << " of Process " << current_thread->getProcessNumber() << " moves from RUNNING to BLOCKED" << std::endl;
-				}
+				transition(*current_thread, STATE_RUNNING, STATE_BLOCKED);
 
-				/*add thread to io_queue*/
+				/*send thread to the device of its io burst*/
 				addThread(current_thread, IO);
 			}
 
@@ -200,6 +452,7 @@ int	CPUSim::executeThreadRR(SimQueue & q)
 	{
 		/*current thread set beforehand*/
 		/*set timings sets the length of the CPU and IO bursts to be executed right now*/
+		current_thread->setDispatchTime(clock);
 		current_thread->setTimings();
 		/*set the CPU wait to the length of the time quantum*/
 		wait = time_quantum;
@@ -217,11 +470,8 @@ int	CPUSim::executeThreadRR(SimQueue & q)
 			current_thread->setIOThreadTotal(current_thread->getIOTimeRemaining() + current_thread->getIOThreadTotal());
 		}
 
-		/*verbose print*/
-		if (verbose == SET)
-		{
-			std::cout << "At Time " << clock << ": Thread " << current_thread->getThreadNumber() << " of Process " << current_thread->getProcessNumber() << " moves from READY to RUNNING" << std::endl;
-		}
+		/*verbose print and event log*/
+		transition(*current_thread, STATE_READY, STATE_RUNNING);
 
 		/*the cpu is now executing a burst so we chaning the cpu_is_executing to reflect that*/
 		cpu_is_executing = 1;
@@ -252,21 +502,21 @@ int	CPUSim::executeThreadRR(SimQueue & q)
 				/*add to the queue that holds all exited threads (passed to this function)*/
 				q.addThread(current_thread);
 
-				/*verbose print*/
-				if (verbose == SET)
+				/*stream the finished thread to the results file, if one is open*/
+				if (results_out != nullptr)
 				{
-					std::cout << "At Time " << clock << ": Thread " << current_thread->getThreadNumber() << " of Process " << current_thread->getProcessNumber() << " moves from RUNNING to EXIT" << std::endl;
+					results_out->addThread(makeThreadResult(*current_thread));
 				}
+
+				/*verbose print and event log*/
+				transition(*current_thread, STATE_RUNNING, STATE_EXIT);
 			}
 			/*add the rest of the burst back to the execution stack*/
 			else if (wait == 1 && current_thread->getCPUTime() != 1)
 			{
 				current_thread->addBurst(current_thread->getCPUTime(), current_thread->getIOTimeRemaining());
 				/*if not exiting, move the thread to the IO queue so it can do its IO time*/
-				if (verbose == SET)
-				{
-					std::cout << "At Time " << clock << ": Thread " << current_thread->getThreadNumber() << " of Process " << current_thread->getProcessNumber() << " moves from RUNNING to READY" << std::endl;
-				}
+				transition(*current_thread, STATE_RUNNING, STATE_READY);
 
 				/*add thread to io_queue*/
 				addThread(current_thread, READY);
@@ -274,13 +524,10 @@ int	CPUSim::executeThreadRR(SimQueue & q)
 			else
 			{
 				/*if not exiting, move the thread to the IO queue so it can do its IO time*/
-				if (verbose == SET)
-				{
-					std::cout << "At Time " << clock << ": Thread " << current_thread->getThreadNumber() << " of Process " << current_thread->getProcessNumber() << " moves from RUNNING to BLOCKED" << std::endl;
-				}
+				transition(*current_thread, STATE_RUNNING, STATE_BLOCKED);
 
 
-				/*add thread to io_queue*/
+				/*send thread to the device of its io burst*/
 				addThread(current_thread, IO);
 			}
 
@@ -307,19 +554,16 @@ int CPUSim::getNumberOfThreads()
 
 int CPUSim::getNextThread()
 {
-	std::shared_ptr<Thread>  next_thread = nullptr;
-
 	/*grab thread from ready queue*/
-	next_thread = ready_queue.removeThread();
-
-	if (next_thread != nullptr)
+	if (!ready_queue.empty())
 	{
 		/*sets the current thread of the cpu to the thread pulled from the ready queue
 		this thread will be used once the cpu goes into EXECUTING mode*/
-		current_thread = next_thread;
+		current_thread = threads[ready_queue.pop()];
+		int process = current_thread->getProcessIndex();
 
 		/*if the previous thread was from the same process, we do a thread switch*/
-		if (prev_process == current_thread->getProcessNumber())
+		if (prev_process == process)
 		{
 			/*cpu goes into thread switch mode*/
 			setMode(TSWITCH);
@@ -327,9 +571,22 @@ int CPUSim::getNextThread()
 		else /*if not from the same process, we do a process switch*/
 		{
 			/*set the new previous process*/
-			prev_process = current_thread->getProcessNumber();
+			prev_process = process;
 			/*change cpu to process switch mode*/
 			setMode(PSWITCH);
+
+			/*the affinity model costs the switch by where the process is cached*/
+			if (affinity == SET)
+			{
+				wait = affinitySwitch(*current_thread);
+			}
+		}
+		/*once it has run here, the process is cached by this cpu*/
+		current_thread->setMigrated(false);
+
+		if (process >= 0 && process < (int)process_switches.size())
+		{
+			process_switches[process]++;
 		}
 	}
 
@@ -339,22 +596,20 @@ int CPUSim::getNextThread()
 void CPUSim::advanceClock()
 {
 	clock++;
-
-	io_queue.decrementAllIO();
 }
 
-void CPUSim::calculateStatistics(SimQueue & q)
+void CPUSim::calculateStatistics()
 {
-	clock--; /*one extra clock tick upon exit, so removing it here*/
+	SimResults results = getResults();
 
-			 /*if detailed is set, get detailed statistics*/
+	/*if detailed is set, get detailed statistics*/
 	if (detailed == SET)
 	{
-		stats_detailed(*this, q);
+		stats_detailed(results);
 	}
 	else
 	{
-		stats_default(*this, q);
+		stats_default(results);
 	}
 
 }
@@ -375,7 +630,9 @@ void CPUSim::checkStatus()
 
 void CPUSim::executeThread(SimQueue & q)
 {
-	if (round_robin = SET)
+	/*an assignment on purpose: the original simulator always runs the RR path (which
+	behaves as FCFS without a quantum), and results must stay identical to it*/
+	if ((round_robin = SET))
 	{
 		executeThreadRR(q);
 	}
@@ -392,59 +649,86 @@ void CPUSim::setMode(Mode mode)
 		/*if we are switching into threadswitch mode, the cpu wait is set to
 		the length of thread switch parsed from file*/
 		wait = thread_switch;
+		context_switches++;
 	}
 	else if (mode == PSWITCH)
 	{
 		/*same for process switch*/
 		wait = process_switch;
+		context_switches++;
 	}
 
 	/*set the mode now*/
 	this->mode = mode;
 }
 
+int CPUSim::affinitySwitch(Thread & t)
+{
+	/*still cached here, the previous process is always at the front of the set*/
+	if (recent.touch(t.getProcessIndex()))
+	{
+		warm_switches++;
+		return warm_switch;
+	}
+
+	/*the dispatcher placed the thread away from the cpu that caches its process*/
+	if (t.isMigrated())
+	{
+		migrated_switches++;
+		return migration_switch;
+	}
+
+	cold_switches++;
+	return cold_switch;
+}
 
-void stats_default(CPUSim & cpu, SimQueue q)
+void CPUSim::transition(Thread & t, ThreadState from, ThreadState to)
 {
-	float cpu_util = 0;
-	int total_time = cpu.clock;
+	if (verbose == SET)
+	{
+		std::cout << "At Time " << clock << ": Thread " << t.getThreadNumber() << " of Process " << t.getProcessNumber() << " moves from " << threadStateName(from) << " to " << threadStateName(to) << std::endl;
+	}
 
-	/*calculate cpu utilization*/
-	cpu_util = ((float)cpu.total_cpu_execution_time / cpu.clock) * 100;
+	if (event_log != nullptr)
+	{
+		event_log->add(clock, t.getProcessNumber(), t.getThreadNumber(), from, to);
+	}
+}
 
+void stats_default(const SimResults & results)
+{
 	/*pass to print function*/
-	printDefaultStats(cpu, q, cpu_util, total_time);
+	printDefaultStats(results);
 }
 
 /*prints the final stats of the CPUSim in detailed mode, threads presented in exit order*/
-void stats_detailed(CPUSim & cpu, SimQueue q)
+void stats_detailed(const SimResults & results)
 {
 	/*default stats are part of the detailed stats*/
-	stats_default(cpu, q);
+	stats_default(results);
 
-	/*temp thread points to head of the exit_queue which contains all exited threads*/
-
-	for (auto p : q.q)
+	/*threads in the results are stored in exit order*/
+	for (const ThreadResult & r : results.threads)
 	{
 		/*print detailed info*/
 		printf("\n");
-		printf("Thread %d of Process %d:\n\n", p->getThreadNumber(), p->getProcessNumber());
-		printf("arrival time: %d\n", p->getArrivalTime());
-		printf("service time: %d\n", p->getCPUThreadTotal());
-		printf("I/O time: %d\n", p->getIOThreadTotal());
-		printf("turnaround time: %d\n", p->getExitTime() - p->getArrivalTime());
-		printf("exit time: %d\n", p->getExitTime());
+		printf("Thread %d of Process %d:\n\n", r.thread_number, r.process_number);
+		printf("arrival time: %d\n", r.arrival_time);
+		printf("service time: %d\n", r.service_time);
+		printf("I/O time: %d\n", r.io_time);
+		printf("turnaround time: %d\n", r.turnaround_time);
+		printf("exit time: %d\n", r.exit_time);
 		printf("\n");
 	}
 }
 
 /*printing function*/
-void printDefaultStats(CPUSim & cpu, SimQueue q, float cpu_util, int time)
+void printDefaultStats(const SimResults & results)
 {
 	/*chooses which mode to print out based on what mode the cpu executed in*/
-	if (cpu.time_quantum != -1)
+	if (results.time_quantum != -1)
 	{
-		printf("\nRound Robin (with time quantum = %d): \n\n", cpu.time_quantum);
+		printf("\nRound Robin (with time quantum = %d): \n\n", results.time_quantum);
 	}
 	else
 	{
@@ -452,195 +736,355 @@ void printDefaultStats(CPUSim & cpu, SimQueue q, float cpu_util, int time)
 	}
 
 	/*printing default stats*/
-	printf("Total Time required is %d time units\n", time);
-	printf("Average Turnaround Time is %.1f time units\n", turnaroundTime(cpu, q));
-	printf("CPU Utilization is %.0f percent\n\n", cpu_util);
-}
+	printf("Total Time required is %d time units\n", results.total_time);
+	printf("Average Turnaround Time is %.1f time units\n", results.average_turnaround);
+	printf("CPU Utilization is %.0f percent\n\n", results.cpu_utilization);
 
-float turnaroundTime(CPUSim & cpu, SimQueue q)
-{
-	float arr_temp = 0;
-	float exit_temp = 0;
-	float turnaround = 0;
-	std::shared_ptr<Thread> temp = nullptr;
+	/*context switches by kind, only under the affinity model*/
+	if (results.affinity)
+	{
+		printf("Context Switches: %d thread, %d warm, %d cold, %d migrated\n\n", results.thread_switches,
+			results.warm_switches, results.cold_switches, results.migrated_switches);
+	}
 
-	for (int i = 1; i <= cpu.num_of_processes; i++)
+	/*io devices, only if they were configured*/
+	for (size_t i = 0; i < results.devices.size(); i++)
 	{
-		arr_temp = exit_temp = 0;
+		const DeviceResult & d = results.devices[i];
+		char name[32];
 
-		for (auto p : q.q)
+		if (d.config.discipline == IO_FIFO)
 		{
-			if (p->getProcessNumber() == i)
-			{
-				arr_temp = p->getArrivalTime();
-				exit_temp = p->getExitTime();
-			}
+			snprintf(name, sizeof(name), "fifo");
 		}
-
-		turnaround += (exit_temp - arr_temp);
+		else if (d.config.channels == IO_UNLIMITED_CHANNELS)
+		{
+			snprintf(name, sizeof(name), "unlimited channels");
+		}
+		else
+		{
+			snprintf(name, sizeof(name), "%d channels", d.config.channels);
+		}
+		printf("I/O Device %zu (%s): %lld requests, utilization %.0f percent, average queueing delay %.1f time units (max %d)\n",
+			i, name, d.requests, d.utilization, d.average_wait, d.max_wait);
+	}
+	if (!results.devices.empty())
+	{
+		printf("\n");
 	}
-
-	return turnaround / (cpu.num_of_processes);
 }
 
-int initializeJobQueue(CPUSim & cpu)
+float turnaroundTime(CPUSim & cpu, SimQueue & q)
 {
+	std::vector<ProcessResult> processes = makeProcessResults(cpu.process_table);
 
-	parseCPUInfo(cpu); /*parses the first line of the file bc it does not show up in the file pattern again*/
-
-	parseProcesses(cpu); /*parse all processes in the file, based off of info from parseCPUInfo*/
-
-						 /*after all processes are parsed, set the number of threads the cpu has, to the size
-						 of the job queue*/
-	cpu.num_of_threads = cpu.job_queue.size();
+	/*one pass over the exited threads, a later exit overwrites the turnaround of its process*/
+	for (auto p : q.q)
+	{
+		int process = p->getProcessIndex();
+		if (process >= 0 && process < (int)processes.size())
+		{
+			addToProcessResult(processes[process], makeThreadResult(*p));
+		}
+	}
 
-	return 1;
+	return averageTurnaround(processes, cpu.num_of_processes);
 }
 
-/*responsible for parsing all processes and their threads in file*/
-int parseProcesses(CPUSim & cpu)
+std::vector<ProcessResult> makeProcessResults(const ProcessTable & table)
 {
-	int process_num = 0;
+	std::vector<ProcessResult> processes(table.size());
 
-	/*for the number of processes in the file...*/
-	for (int i = 0; i < cpu.num_of_processes; i++)
+	for (int i = 0; i < table.size(); i++)
 	{
-		/*scan in process number, and num of threads in said process*/
-		std::cin.ignore(200, '\n');
-		std::cin >> process_num >> cpu.num_of_threads;
-		/*parse threads based off number of threads in process*/
-		parseThreads(cpu, process_num);
+		ProcessResult & p = processes[i];
+		p.process_number = table.getProcessNumber(i);
+		p.num_of_threads = 0;
+		p.first_arrival = -1;
+		p.last_exit = -1;
+		p.service_time = 0;
+		p.io_time = 0;
+		p.switches = 0;
+		p.turnaround_time = 0;
 	}
 
-	return 1;
+	return processes;
 }
 
-/*responsible for parsing all threads in a given process*/
-int parseThreads(CPUSim & cpu, int process_num)
+void addToProcessResult(ProcessResult & p, const ThreadResult & r)
 {
-	/*for all threads in a process...*/
-	for (int i = 0; i < cpu.getNumberOfThreads(); i++)
+	if (p.num_of_threads == 0 || r.arrival_time < p.first_arrival)
 	{
-		/*parse a thread*/
-		parseThread(cpu, process_num);
+		p.first_arrival = r.arrival_time;
 	}
-
-	return 1;
+	if (r.exit_time >= p.last_exit)
+	{
+		/*threads are added in exit order, so this is the last one to exit so far*/
+		p.last_exit = r.exit_time;
+		p.turnaround_time = r.turnaround_time;
+	}
+	p.num_of_threads++;
+	p.service_time += r.service_time;
+	p.io_time += r.io_time;
 }
 
-/*parses one thread from file*/
-int parseThread(CPUSim & cpu, int process_num)
+float averageTurnaround(const std::vector<ProcessResult> & processes, int num_of_processes)
 {
-	int thread_number = 0;
-	int arrival_time = -1;
-	int num_of_bursts = 0;
-	std::shared_ptr<Thread> new_thread = NULL;
+	float turnaround = 0;
 
-	/*scan in thread num wrt to process, its arrival time, and number of cpu burts*/
-	std::cin.ignore(200, '\n');
-	std::cin >> thread_number >> arrival_time >> num_of_bursts;
+	for (const ProcessResult & p : processes)
+	{
+		turnaround += p.turnaround_time;
+	}
 
-	/*create a new thread object with parsed info*/
-	new_thread = std::make_shared<Thread>(process_num, thread_number, arrival_time, num_of_bursts);
+	return turnaround / std::max(num_of_processes, (int)processes.size());
+}
 
-	/*parse the execution stack of the thread based on 'num_of_bursts'*/
-	parseBursts(new_thread);
+DeviceResult makeDeviceResult(const IODeviceConfig & config)
+{
+	DeviceResult d;
 
-	/*add the thread to the job queue inside our cpu sim*/
-	cpu.addThread(new_thread, JOB);
+	d.config = config;
+	d.requests = 0;
+	d.busy_time = 0;
+	d.total_wait = 0;
+	d.max_wait = 0;
+	d.utilization = 0;
+	d.average_wait = 0;
 
-	return 1;
+	return d;
 }
 
-/*parses the execution stack of one thread*/
-int parseBursts(std::shared_ptr<Thread> thread)
+void addToDeviceResult(DeviceResult & d, const IODevice & device)
 {
-	int burst_num = 0;
-	int cpu_time = 0;
-	int io_time = 0;
+	d.requests += device.requests;
+	d.busy_time += device.busy_time;
+	d.total_wait += device.total_wait;
+	d.max_wait = std::max(d.max_wait, device.max_wait);
+}
 
-	if (!thread)
-	{
-		return -1;
-	}
+void finishDeviceResult(DeviceResult & d, long long available)
+{
+	d.utilization = (available > 0) ? ((float)d.busy_time / available) * 100 : 0;
+	d.average_wait = (d.requests > 0) ? (float)d.total_wait / d.requests : 0;
+}
 
-	/*for x-1 number of bursts in the stack...*/
-	for (int i = 0; i < (thread->getNumberOfBursts() - 1); i++)
+bool parseIODevices(const char * spec, std::vector<IODeviceConfig> & devices)
+{
+	std::stringstream list(spec);
+	std::string item;
+
+	devices.clear();
+	while (std::getline(list, item, ','))
 	{
-		/*scan in info*/
-		std::cin.ignore(200, '\n');
-		std::cin >> burst_num >> cpu_time >> io_time;
-		/*add info to execution stack object (BurstQueue) inside the already created thread*/
-		thread->addBurst(cpu_time, io_time);
+		IODeviceConfig device;
+
+		if (item == "fifo")
+		{
+			device.discipline = IO_FIFO;
+			device.channels = 1;
+		}
+		else if (item == "inf")
+		{
+			device.discipline = IO_PARALLEL;
+			device.channels = IO_UNLIMITED_CHANNELS;
+		}
+		else if (!item.empty() && item.find_first_not_of("0123456789") == std::string::npos && atoi(item.c_str()) > 0)
+		{
+			device.discipline = IO_PARALLEL;
+			device.channels = atoi(item.c_str());
+		}
+		else
+		{
+			return false;
+		}
+		devices.push_back(device);
 	}
 
-	/*scan in the last burst seperatley, because we expect the last burst to have no io*/
-	std::cin.ignore(200, '\n');
-	std::cin >> burst_num >> cpu_time;
-	/*set last io burst to -1 for signal use later*/
-	thread->addBurst(cpu_time, -1);
+	return !devices.empty();
+}
 
-	return 1;
+/*final statistics of a single exited thread*/
+ThreadResult makeThreadResult(Thread & t)
+{
+	ThreadResult r;
+
+	r.process_number = t.getProcessNumber();
+	r.thread_number = t.getThreadNumber();
+	r.arrival_time = t.getArrivalTime();
+	r.start_time = t.getStartTime();
+	r.exit_time = t.getExitTime();
+	r.service_time = t.getCPUThreadTotal();
+	r.io_time = t.getIOThreadTotal();
+	r.turnaround_time = t.getExitTime() - t.getArrivalTime();
+
+	return r;
+}
+
+const char * threadStateName(int state)
+{
+	static const char * names[] = { "NEW", "READY", "RUNNING", "BLOCKED", "EXIT" };
+
+	return (state >= STATE_NEW && state <= STATE_EXIT) ? names[state] : "UNKNOWN";
 }
 
-/*parses the first line of the file*/
-int parseCPUInfo(CPUSim & cpu)
+/*parses a workload from the stream and loads it into the cpu*/
+int initializeJobQueue(CPUSim & cpu, std::istream & in)
 {
-	std::cin >> cpu.num_of_processes >> cpu.thread_switch >> cpu.process_switch;
+	Workload workload;
+
+	parseWorkload(in, workload); /*parse the first line and all processes in the file*/
+
+	cpu.load(workload); /*every parsed thread is placed in the job queue*/
 
 	return 1;
 }
 
-/*responsible for setting flags inside CPUSim object to set output style, scheduling etc...*/
-void processCommandLineArgs(CPUSim & cpu, char ** argv, int argc)
+/*returns the value following option argv[i], exits if there is none*/
+static const char * optionValue(char ** argv, int argc, int i)
 {
-	/*make sure there are not too many arguements on the cmd line, exit if there are too many*/
-	if (argc > 7)
+	if (i + 1 >= argc)
 	{
 		printf("Invalid command line parameters. Exiting.\n");
 		exit(0);
 	}
+	return argv[i + 1];
+}
+
+/*responsible for setting flags inside the command line options to set output style, scheduling etc...*/
+void processCommandLineArgs(CommandLine & cmd, char ** argv, int argc)
+{
+	RunConfig & config = cmd.config;
 
 	/*for all args in argv...*/
-	for (int i = 0; i < argc; i++)
+	for (int i = 1; i < argc; i++)
 	{
-		/*compare arg with flag*/
+		/*compare arg with flag, if flag recognized, set corresponding flag in the run configuration*/
 		if (strcmp(argv[i], "-d") == 0)
 		{
-			/*if flag recognized, set corresponding flag in CPUSim object*/
-			cpu.detailed = SET;
-			break;
+			config.detailed = SET;
 		}
-	}
-
-	for (int i = 0; i < argc; i++)
-	{
-		if (strcmp(argv[i], "-v") == 0)
+		else if (strcmp(argv[i], "-v") == 0)
 		{
-			cpu.verbose = SET;
-			break;
+			config.verbose = SET;
 		}
-	}
-
-	for (int i = 0; i < argc; i++)
-	{
-		if (strcmp(argv[i], "-r") == 0)
+		else if (strcmp(argv[i], "-r") == 0)
 		{
-			cpu.round_robin = SET;
-			break;
+			config.round_robin = SET;
 		}
-	}
+		else if (strcmp(argv[i], "--workload") == 0)
+		{
+			cmd.workload_file = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--trace") == 0)
+		{
+			cmd.trace_file = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--trace-unit") == 0)
+		{
+			cmd.trace_unit_ns = atoll(optionValue(argv, argc, i++));
+		}
+		else if (strcmp(argv[i], "--compress") == 0)
+		{
+			cmd.compress_bursts = true;
+		}
+		else if (strcmp(argv[i], "--results-out") == 0)
+		{
+			cmd.results_file = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--sample-out") == 0)
+		{
+			cmd.sample_file = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--sample-interval") == 0)
+		{
+			cmd.sample_interval = atoi(optionValue(argv, argc, i++));
+		}
+		else if (strcmp(argv[i], "--autotune") == 0)
+		{
+			cmd.autotune = optionValue(argv, argc, i++);
+			if (strcmp(cmd.autotune, "avg") != 0 && strcmp(cmd.autotune, "p99") != 0)
+			{
+				printf("Invalid command line parameters. Exiting.\n");
+				exit(0);
+			}
+		}
+		else if (strcmp(argv[i], "--tune-range") == 0)
+		{
+			cmd.tune_min = atoi(optionValue(argv, argc, i++));
+			cmd.tune_max = atoi(optionValue(argv, argc, i++));
+		}
+		else if (strcmp(argv[i], "--jobs") == 0)
+		{
+			cmd.jobs = atoi(optionValue(argv, argc, i++));
+		}
+		else if (strcmp(argv[i], "--cache") == 0)
+		{
+			cmd.cache_dir = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--serve") == 0)
+		{
+			cmd.serve_path = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--cluster") == 0)
+		{
+			cmd.cluster_nodes = atoi(optionValue(argv, argc, i++));
+		}
+		else if (strcmp(argv[i], "--dispatch") == 0)
+		{
+			cmd.dispatch = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--process-out") == 0)
+		{
+			cmd.process_file = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--io-devices") == 0)
+		{
+			if (!parseIODevices(optionValue(argv, argc, i++), config.io_devices))
+			{
+				printf("Invalid command line parameters. Exiting.\n");
+				exit(0);
+			}
+		}
+		else if (strcmp(argv[i], "--affinity") == 0)
+		{
+			config.affinity = SET;
+			config.warm_switch = atoi(optionValue(argv, argc, i++));
+			config.cold_switch = atoi(optionValue(argv, argc, i++));
+			config.migration_switch = atoi(optionValue(argv, argc, i++));
 
-	/*for all args in argv...*/
-	for (int i = 0; i < argc; i++)
-	{
-		/*check the first letter to see if it is a digit*/
-		if (isdigit(argv[i][0]))
+			/*a switch of no time never ends, as for the switch costs of a workload*/
+			if (config.warm_switch < 1 || config.cold_switch < 1 || config.migration_switch < 1)
+			{
+				printf("Invalid command line parameters. Exiting.\n");
+				exit(0);
+			}
+		}
+		else if (strcmp(argv[i], "--log-out") == 0)
 		{
-			/*if it is, turn that args into an integer, and set time quantum in CPUSim*/
-			int num = atoi(argv[i]);
-			cpu.time_quantum = num;
-			break;
+			cmd.log_file = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--log-query") == 0)
+		{
+			cmd.log_query = optionValue(argv, argc, i++);
+		}
+		else if (strcmp(argv[i], "--range") == 0)
+		{
+			cmd.query_range = true;
+			cmd.range_start = atoi(optionValue(argv, argc, i++));
+			cmd.range_end = atoi(optionValue(argv, argc, i++));
+		}
+		else if (strcmp(argv[i], "--thread") == 0)
+		{
+			cmd.query_range = false;
+			cmd.query_thread = atoi(optionValue(argv, argc, i++));
+			cmd.query_process = atoi(optionValue(argv, argc, i++));
+		}
+		/*check the first letter to see if it is a digit, the first number given is the time quantum*/
+		else if (isdigit(argv[i][0]) && config.time_quantum == NO_QUANTUM_VALUE)
+		{
+			/*if it is, turn that args into an integer, and set time quantum in the run configuration*/
+			config.time_quantum = atoi(argv[i]);
 		}
 	}
 }
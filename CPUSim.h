@@ -1,9 +1,16 @@
 #pragma once
 
+#include "AffinitySet.h"
+#include "IODevice.h"
+#include "RingQueue.h"
 #include "SimQueue.h"
+#include "Workload.h"
 #include <memory>
+#include <vector>
 
+#define ENGINE_VERSION 1        /*bump whenever a change alters simulation results, invalidates cached results*/
 #define NO_QUANTUM_VALUE -1
+#define MIN_RR_QUANTUM 2        /*a quantum of 1 never expires, see executeThreadRR*/
 #define IO_COMPLETED 0
 #define EXIT -99
 
@@ -29,18 +36,219 @@ typedef enum Mode {
 	TSWITCH = 4
 }Mode;
 
+/*states a thread moves between, as reported by -v and the event log*/
+typedef enum ThreadState {
+	STATE_NEW = 0,
+	STATE_READY = 1,
+	STATE_RUNNING = 2,
+	STATE_BLOCKED = 3,
+	STATE_EXIT = 4
+} ThreadState;
+
+
+/*everything that configures a run, independent of the workload being run*/
+struct RunConfig
+{
+	RunConfig()
+	{
+		verbose = UNSET;
+		detailed = UNSET;
+		round_robin = UNSET;
+		time_quantum = NO_QUANTUM_VALUE;
+		thread_switch = -1;
+		process_switch = -1;
+		affinity = UNSET;
+		warm_switch = 0;
+		cold_switch = 0;
+		migration_switch = 0;
+	}
+
+	Flag verbose;               /*SET to print every state transition*/
+	Flag detailed;              /*SET to report per thread statistics*/
+	Flag round_robin;           /*SET to schedule with RR instead of FCFS*/
+	int time_quantum;           /*time quantum for use in RR, NO_QUANTUM_VALUE otherwise*/
+	int thread_switch;          /*overrides the switch costs of the workload when >= 0*/
+	int process_switch;
+	std::vector<IODeviceConfig> io_devices; /*io devices by device number, empty for one unlimited device and no device statistics*/
+	Flag affinity;              /*SET to cost process switches by where the process last ran, see AffinitySet*/
+	int warm_switch;            /*process switch to a process still cached by the core*/
+	int cold_switch;            /*process switch to a process not cached anywhere*/
+	int migration_switch;       /*process switch to a process last cached by another core*/
+};
+
+/*everything simcpu reads from its command line*/
+struct CommandLine
+{
+	CommandLine()
+	{
+		workload_file = nullptr;
+		trace_file = nullptr;
+		trace_unit_ns = 0;
+		compress_bursts = false;
+		results_file = nullptr;
+		sample_file = nullptr;
+		sample_interval = 0;
+		autotune = nullptr;
+		tune_min = 0;
+		tune_max = 0;
+		jobs = 0;
+		cache_dir = nullptr;
+		serve_path = nullptr;
+		cluster_nodes = 0;
+		dispatch = nullptr;
+		process_file = nullptr;
+		log_file = nullptr;
+		log_query = nullptr;
+		query_range = false;
+		range_start = 0;
+		range_end = 0;
+		query_thread = 0;
+		query_process = 0;
+	}
+
+	RunConfig config;           /*flags and quantum of the run*/
+	const char * workload_file; /*--workload: workload file parsed in parallel instead of reading stdin*/
+	const char * trace_file;    /*--trace: linux scheduler trace to replay instead of reading stdin*/
+	long long trace_unit_ns;    /*--trace-unit: nanoseconds per time unit, 0 for the default*/
+	bool compress_bursts;       /*--compress: keep the bursts of the workload compressed in memory*/
+	const char * results_file;  /*--results-out: per thread results file, .csv or packed binary*/
+	const char * sample_file;   /*--sample-out: time series file, .csv or packed binary*/
+	int sample_interval;        /*--sample-interval: time units per sample, 0 for the default*/
+	const char * autotune;      /*--autotune: "avg" or "p99", search the best RR quantum instead of one run*/
+	int tune_min;               /*--tune-range: quanta searched by --autotune, 0 for the defaults*/
+	int tune_max;
+	int jobs;                   /*--jobs: worker threads, 0 for one per hardware thread*/
+	const char * cache_dir;     /*--cache: directory of cached results, nullptr to always simulate*/
+	const char * serve_path;    /*--serve: unix socket to serve runs on instead of doing one run*/
+	int cluster_nodes;          /*--cluster: nodes of a simulated cluster, 0 for a single cpu*/
+	const char * dispatch;      /*--dispatch: "rr", "least", "p2c" or "affinity", how the cluster assigns threads to nodes*/
+	const char * process_file;  /*--process-out: per process statistics as CSV*/
+	const char * log_file;      /*--log-out: binary log of every state transition of the run*/
+	const char * log_query;     /*--log-query: event log to query instead of doing a run*/
+	bool query_range;           /*--range: query the events from range_start to range_end...*/
+	int range_start;
+	int range_end;
+	int query_thread;           /*...otherwise --thread: the events of thread query_thread of process query_process*/
+	int query_process;
+};
+
+/*final statistics of one thread*/
+struct ThreadResult
+{
+	int process_number;
+	int thread_number;
+	int arrival_time;
+	int start_time;
+	int exit_time;
+	int service_time;           /*total cpu time of the thread*/
+	int io_time;                /*total io time of the thread*/
+	int turnaround_time;        /*exit time - arrival time*/
+};
+
+/*final statistics of one process, accumulated over its exited threads*/
+struct ProcessResult
+{
+	int process_number;
+	int num_of_threads;         /*threads of the process that exited*/
+	int first_arrival;          /*earliest arrival of those threads, -1 if there are none*/
+	int last_exit;              /*latest exit of those threads, -1 if there are none*/
+	int service_time;           /*total cpu time of its threads*/
+	int io_time;                /*total io time of its threads*/
+	int switches;               /*thread and process switches into the process*/
+	int turnaround_time;        /*turnaround of its thread that exited last, as averaged by the statistics*/
+};
+
+/*final statistics of one io device*/
+struct DeviceResult
+{
+	IODeviceConfig config;
+	long long requests;         /*io bursts served*/
+	long long busy_time;        /*time units with at least one burst in service*/
+	long long total_wait;       /*time units bursts waited for a channel*/
+	int max_wait;               /*longest a burst waited for a channel*/
+	float utilization;          /*percentage of the run the device was busy*/
+	float average_wait;         /*average queueing delay of a burst*/
+};
+
+/*final statistics of a run, threads are stored in exit order*/
+struct SimResults
+{
+	SimResults()
+	{
+		time_quantum = NO_QUANTUM_VALUE;
+		total_time = 0;
+		average_turnaround = 0;
+		cpu_utilization = 0;
+		affinity = false;
+		thread_switches = 0;
+		warm_switches = 0;
+		cold_switches = 0;
+		migrated_switches = 0;
+	}
+
+	int time_quantum;           /*quantum the run used, NO_QUANTUM_VALUE for FCFS*/
+	int total_time;             /*time units until the last thread exited*/
+	float average_turnaround;   /*average turnaround time over all processes*/
+	float cpu_utilization;      /*percentage of total_time the cpu was executing*/
+	std::vector<ThreadResult> threads;
+	std::vector<ProcessResult> processes;  /*in process table order, not kept by the result cache*/
+	std::vector<DeviceResult> devices;     /*by device number if devices were configured, not kept by the result cache*/
+	bool affinity;              /*true if the run used the affinity cost model, the switch counts are only set then*/
+	int thread_switches;        /*switches to another thread of the same process*/
+	int warm_switches;          /*process switches by kind, see RunConfig*/
+	int cold_switches;
+	int migrated_switches;
+};
+
+class EventLog;
+class ResultsWriter;
+class Sampler;
 
 class CPUSim
 {
 public:
 	CPUSim();
 
+	/*applies a run configuration, call before load()*/
+	void configure(const RunConfig & config);
+
+	/*resets the simulator and places every thread of the workload in the job queue.
+	The cpu keeps its own copy of the process table and a reference on the compressed
+	bursts, so the workload may be destroyed or cleared before the run*/
+	void load(const Workload & workload);
+
+	/*adds one more thread to the job queue, it arrives when the clock reaches its arrival time.
+	A migrated thread belongs to a process whose working set is cached by another cpu*/
+	void admit(const ThreadSpec & spec, bool migrated = false);
+
+	/*moves the clock of a cpu whose threads have all exited straight to time. The ticks skipped
+	would have done nothing, so this gives the same results as stepping there, but no samples*/
+	void idleUntil(int time);
+
+	/*puts the simulator back into the state it had after construction + configure()*/
+	void reset();
+
+	/*advances the simulation by one clock tick, returns false once every thread has exited*/
+	bool step();
+
+	/*steps until every thread has exited and returns the final statistics*/
+	SimResults run();
+
+	/*builds the statistics of a finished run*/
+	SimResults getResults();
+
+	/*records a time series sample through s at every sampling interval, nullptr to stop*/
+	void setSampler(Sampler * s);
+
 	void addFinishedIOThreadsToReadyQueue();
 
 	void addArrivingIOThreadsToReadyQueue();
 
 	void addThread(std::shared_ptr<Thread> thread, Destination dest);
 
+	/*threads blocked on io, in service or waiting for a device*/
+	int getIODepth();
+
 	bool canContinue(SimQueue & exit_queue);
 
 	int executeThreadFCFS(SimQueue & q);
@@ -55,13 +263,20 @@ public:
 
 	void advanceClock();
 
-	void calculateStatistics(SimQueue & q);
+	/*prints the final statistics of the run to stdout*/
+	void calculateStatistics();
 
 	void checkStatus();
 
 	void executeThread(SimQueue & q);
 
 	void setMode(Mode mode);
+
+	/*cost of a process switch to t under the affinity model, and counts it by kind*/
+	int affinitySwitch(Thread & t);
+
+	/*every state transition of a thread goes through here, to the verbose output and the event log*/
+	void transition(Thread & t, ThreadState from, ThreadState to);
 	
 public:
 	Flag verbose;               /*SET if -v included in program invokation*/
@@ -71,45 +286,81 @@ public:
 	int cpu_is_executing;       /*set to 1 when the CPU is in the middle of a burst, 0 otherwise*/
 	int num_of_threads;         /*total number of threads in all processes in CPU*/
 	int num_of_processes;       /*number of processes being worked on by CPU*/
-	int prev_process;           /*process number of previous process, uses for choosing between thread or process switch*/
+	int prev_process;           /*process index of previous process, uses for choosing between thread or process switch*/
 	int process_switch;         /*time it takes to switch process*/
 	int thread_switch;          /*time it takes to switch to different thread in same procees*/
 	int time_quantum;           /*time quantum for use in RR if included*/
+	int thread_switch_override;     /*switch costs from the run configuration, -1 to use the workload's*/
+	int process_switch_override;
 	int total_cpu_execution_time;   /*incremented for every CPU tick in which it is executing*/
+	int context_switches;       /*thread and process switches started so far*/
+	Flag affinity;              /*SET to cost process switches with the affinity model*/
+	int warm_switch;            /*costs of the affinity model, see RunConfig*/
+	int cold_switch;
+	int migration_switch;
+	AffinitySet recent;         /*processes cached by the cpu under the affinity model*/
+	int warm_switches;          /*process switches so far by kind under the affinity model*/
+	int cold_switches;
+	int migrated_switches;
 	int wait;                   /*tells the cpu for how long to wait during context switch/burst execution before changing mode*/
 	Mode mode;                  /*current mode of the CPU*/
 	std::shared_ptr<Thread> current_thread;    /*the thread that the CPU is currently working on*/
-	SimQueue ready_queue; /*CPU ready queue*/
-	SimQueue io_queue;    /*CPU io queue, home of blocked threads*/
+	RingQueue ready_queue; /*CPU ready queue, indices into threads*/
+	std::vector<IODevice> io_devices;   /*home of blocked threads, a burst for an unknown device goes to device 0*/
+	bool report_devices;        /*true if the devices were configured, only then are they in the results*/
 	SimQueue job_queue;   /*all threads parsed from file are initialized into job queue*/
+	SimQueue exit_queue;  /*threads that have finished, in exit order*/
+	std::vector<std::shared_ptr<Thread>> threads;  /*every loaded thread, in workload order*/
+	ProcessTable process_table; /*processes of the loaded workload, copied so the workload need not outlive the run*/
+	std::shared_ptr<BurstStore> store;  /*compressed bursts the cursors of the threads decode from*/
+	std::vector<int> process_switches;  /*switches into each process so far, by process index*/
+	ResultsWriter * results_out;    /*if set, every thread is written here as it exits*/
+	Sampler * sampler;          /*if set, records utilization and queue depths over time*/
+	EventLog * event_log;       /*if set, every state transition is logged here*/
+	int next_sample_time;       /*clock at which sampler takes its next sample, INT_MAX without one*/
 };
 
-void stats_default(CPUSim & cpu, SimQueue q);
+void stats_default(const SimResults & results);
 
 /*prints the final stats of the CPUSim in detailed mode, threads presented in exit order*/
-void stats_detailed(CPUSim & cpu, SimQueue q);
+void stats_detailed(const SimResults & results);
 
 /*printing function*/
-void printDefaultStats(CPUSim & cpu, SimQueue q, float cpu_util, int time);
+void printDefaultStats(const SimResults & results);
+
+float turnaroundTime(CPUSim & cpu, SimQueue & q);
+
+/*per process statistics of every process of table, with nothing accumulated yet*/
+std::vector<ProcessResult> makeProcessResults(const ProcessTable & table);
+
+/*adds an exited thread to the statistics of its process*/
+void addToProcessResult(ProcessResult & p, const ThreadResult & r);
+
+/*average over all processes of the turnaround of their last thread to exit. A workload may
+declare more processes than it has, those count with a turnaround of 0*/
+float averageTurnaround(const std::vector<ProcessResult> & processes, int num_of_processes);
 
-float turnaroundTime(CPUSim & cpu, SimQueue q);
+/*statistics of an io device with nothing accumulated yet*/
+DeviceResult makeDeviceResult(const IODeviceConfig & config);
 
-int initializeJobQueue(CPUSim & cpu);
+/*adds what device served to its statistics*/
+void addToDeviceResult(DeviceResult & d, const IODevice & device);
 
-/*responsible for parsing all processes and their threads in file*/
-int parseProcesses(CPUSim & cpu);
+/*computes utilization and average delay of d over available time units of its device*/
+void finishDeviceResult(DeviceResult & d, long long available);
 
-/*responsible for parsing all threads in a given process*/
-int parseThreads(CPUSim & cpu, int process_num);
+/*reads a comma separated list of devices, "fifo", "inf" or a number of parallel channels,
+returns false if it is not one*/
+bool parseIODevices(const char * spec, std::vector<IODeviceConfig> & devices);
 
-/*parses one thread from file*/
-int parseThread(CPUSim & cpu, int process_num);
+/*final statistics of a single exited thread*/
+ThreadResult makeThreadResult(Thread & t);
 
-/*parses the execution stack of one thread*/
-int parseBursts(std::shared_ptr<Thread> thread);
+/*name of a thread state as printed by -v*/
+const char * threadStateName(int state);
 
-/*parses the first line of the file*/
-int parseCPUInfo(CPUSim & cpu);
+/*parses a workload from the stream and loads it into the cpu*/
+int initializeJobQueue(CPUSim & cpu, std::istream & in);
 
-/*responsible for setting flags inside CPUSim object to set output style, scheduling etc...*/
-void processCommandLineArgs(CPUSim & cpu, char ** argv, int argc);
+/*responsible for setting flags inside the command line options to set output style, scheduling etc...*/
+void processCommandLineArgs(CommandLine & cmd, char ** argv, int argc);
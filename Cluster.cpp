@@ -0,0 +1,390 @@
+#include "Cluster.h"
+#include <algorithm>
+#include <barrier>
+#include <climits>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+/*splitmix64, the generator BurstGenerator uses*/
+static uint64_t nextRandom(uint64_t & state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/*threads handed to the node that have not exited yet*/
+static int nodeLoad(CPUSim & node)
+{
+	return node.num_of_threads - node.exit_queue.size();
+}
+
+/*node statistics, utilization is left to the caller as it depends on the cluster total time*/
+static NodeResult makeNodeResult(CPUSim & node)
+{
+	NodeResult r;
+	float turnaround = 0;
+
+	r.num_of_threads = (int)node.threads.size();
+	r.total_time = (r.num_of_threads > 0) ? node.clock - 1 : 0; /*one extra clock tick upon exit*/
+	r.busy_time = node.total_cpu_execution_time;
+
+	for (auto p : node.exit_queue.q)
+	{
+		turnaround += p->getExitTime() - p->getArrivalTime();
+	}
+	r.average_turnaround = (r.num_of_threads > 0) ? turnaround / r.num_of_threads : 0;
+
+	return r;
+}
+
+/*merges the exited threads of every node into one exit order and computes the cluster totals
+the same way getResults does for a single cpu*/
+static SimResults mergeResults(std::vector<CPUSim> & nodes, const Workload & workload, int time_quantum)
+{
+	SimResults results;
+	long long busy = 0;
+
+	results.time_quantum = time_quantum;
+	results.total_time = 0;
+
+	for (CPUSim & node : nodes)
+	{
+		for (auto p : node.exit_queue.q)
+		{
+			results.threads.push_back(makeThreadResult(*p));
+		}
+		busy += node.total_cpu_execution_time;
+		if (!node.threads.empty())
+		{
+			results.total_time = std::max(results.total_time, node.clock - 1);
+		}
+	}
+
+	/*each node is already in exit order, a stable sort keeps ties in node order*/
+	std::stable_sort(results.threads.begin(), results.threads.end(),
+		[](const ThreadResult & a, const ThreadResult & b) { return a.exit_time < b.exit_time; });
+
+	results.cpu_utilization = (results.total_time > 0) ? ((float)busy / ((float)results.total_time * nodes.size())) * 100 : 0;
+
+	/*switches happen on the nodes, so their kinds add up*/
+	if (!nodes.empty() && nodes[0].affinity == SET)
+	{
+		results.affinity = true;
+		for (CPUSim & node : nodes)
+		{
+			results.warm_switches += node.warm_switches;
+			results.cold_switches += node.cold_switches;
+			results.migrated_switches += node.migrated_switches;
+			results.thread_switches += node.context_switches - node.warm_switches - node.cold_switches - node.migrated_switches;
+		}
+	}
+
+	/*every node has its own copy of each device, its utilization is over all the copies*/
+	if (!nodes.empty() && nodes[0].report_devices)
+	{
+		for (size_t i = 0; i < nodes[0].io_devices.size(); i++)
+		{
+			DeviceResult d = makeDeviceResult(nodes[0].io_devices[i].getConfig());
+			for (CPUSim & node : nodes)
+			{
+				addToDeviceResult(d, node.io_devices[i]);
+			}
+			finishDeviceResult(d, (long long)results.total_time * nodes.size());
+			results.devices.push_back(d);
+		}
+	}
+
+	/*threads of a process may have run on different nodes, their switches add up*/
+	results.processes = makeProcessResults(workload.processes);
+	for (const ThreadResult & r : results.threads)
+	{
+		int process = workload.processes.find(r.process_number);
+		if (process >= 0)
+		{
+			addToProcessResult(results.processes[process], r);
+		}
+	}
+	for (CPUSim & node : nodes)
+	{
+		for (size_t i = 0; i < node.process_switches.size(); i++)
+		{
+			results.processes[i].switches += node.process_switches[i];
+		}
+	}
+	results.average_turnaround = averageTurnaround(results.processes, workload.num_of_processes);
+
+	return results;
+}
+
+ClusterResults runCluster(const Workload & workload, const ClusterOptions & options)
+{
+	int num_of_nodes = std::max(1, options.num_of_nodes);
+	int num_workers = options.num_workers;
+	RunConfig config = options.config;
+	Workload shell;
+	ClusterResults results;
+
+	if (num_workers <= 0)
+	{
+		num_workers = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	num_workers = std::min(num_workers, num_of_nodes);
+
+	/*transitions of nodes running in parallel would interleave on stdout*/
+	config.verbose = UNSET;
+
+	/*nodes start out empty but know the switch costs and processes of the workload*/
+	shell.num_of_processes = workload.num_of_processes;
+	shell.processes = workload.processes;
+	shell.setSwitchCosts(workload.thread_switch, workload.process_switch);
+
+	std::vector<CPUSim> nodes(num_of_nodes);
+	for (CPUSim & node : nodes)
+	{
+		node.configure(config);
+		node.load(shell);
+	}
+
+	/*threads in order of arrival, threads arriving together in workload order*/
+	std::vector<int> order(workload.threads.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+		[&](int a, int b) { return workload.threads[a].arrival_time < workload.threads[b].arrival_time; });
+
+	std::vector<int> loads(num_of_nodes, 0);
+	std::vector<std::pair<int, int>> heap;  /*(load, node) of DISPATCH_LEAST_LOADED and DISPATCH_AFFINITY*/
+	std::vector<std::vector<int>> changed(num_workers);    /*nodes whose load a worker changed since the last dispatch point*/
+	bool use_heap = options.policy == DISPATCH_LEAST_LOADED || options.policy == DISPATCH_AFFINITY;
+	std::vector<int> home(workload.processes.size(), -1);   /*node the last thread of each process went to*/
+	std::vector<std::vector<int>> assigned; /*threads of every node, DISPATCH_ROUND_ROBIN only*/
+	std::vector<char> migrated_of;          /*migrated flag of every thread, DISPATCH_ROUND_ROBIN only*/
+	size_t next = 0;                        /*next thread of order to dispatch*/
+	uint64_t random_state = options.seed;
+	int target = order.empty() ? INT_MAX : workload.threads[order[0]].arrival_time;
+
+	/*round robin does not look at the nodes, so every thread is assigned up front and
+	each node is fed its threads as its own clock reaches their arrival times*/
+	if (options.policy == DISPATCH_ROUND_ROBIN)
+	{
+		assigned.resize(num_of_nodes);
+		migrated_of.resize(order.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			int n = (int)(i % num_of_nodes);
+			int process = workload.threads[order[i]].process_index;
+
+			assigned[n].push_back(order[i]);
+			migrated_of[order[i]] = home[process] >= 0 && home[process] != n;
+			home[process] = n;
+		}
+	}
+
+	/*every node always has an entry (loads[node], node) in the heap. A node gets a new entry
+	whenever its load changes, the old one goes stale and is dropped once it surfaces*/
+	auto pushLoad = [&](int node)
+	{
+		heap.push_back(std::make_pair(loads[node], node));
+		std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int>>());
+	};
+
+	if (use_heap)
+	{
+		for (int i = 0; i < num_of_nodes; i++)
+		{
+			pushLoad(i);
+		}
+	}
+
+	/*runs on one host thread while all others wait, every node has been stepped to target*/
+	auto dispatch = [&]() noexcept
+	{
+		if (use_heap)
+		{
+			/*only nodes whose threads exited since the last dispatch point get a new entry,
+			the heap is rebuilt once stale entries outnumber the nodes*/
+			for (std::vector<int> & nodes_changed : changed)
+			{
+				for (int i : nodes_changed)
+				{
+					pushLoad(i);
+				}
+				nodes_changed.clear();
+			}
+			if ((int)heap.size() > 2 * num_of_nodes)
+			{
+				heap.clear();
+				for (int i = 0; i < num_of_nodes; i++)
+				{
+					heap.push_back(std::make_pair(loads[i], i));
+				}
+				std::make_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int>>());
+			}
+		}
+
+		while (next < order.size() && workload.threads[order[next]].arrival_time == target)
+		{
+			const ThreadSpec & spec = workload.threads[order[next]];
+			int n = 0;
+
+			if (use_heap)
+			{
+				while (heap.front().first != loads[heap.front().second])
+				{
+					std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int>>());
+					heap.pop_back();
+				}
+
+				/*the least loaded node, or the home node while it is not too far behind*/
+				n = heap.front().second;
+				if (options.policy == DISPATCH_AFFINITY && home[spec.process_index] >= 0
+					&& loads[home[spec.process_index]] <= heap.front().first + AFFINITY_SLACK)
+				{
+					n = home[spec.process_index];
+				}
+			}
+			else
+			{
+				int a = (int)(nextRandom(random_state) % num_of_nodes);
+				int b = a;
+				if (num_of_nodes > 1)
+				{
+					b = (a + 1 + (int)(nextRandom(random_state) % (num_of_nodes - 1))) % num_of_nodes;
+				}
+				n = (loads[b] < loads[a]) ? b : a;
+			}
+
+			/*the process is cached where its last thread went, elsewhere the thread migrates*/
+			bool migrated = home[spec.process_index] >= 0 && home[spec.process_index] != n;
+			home[spec.process_index] = n;
+
+			loads[n]++;
+			if (use_heap)
+			{
+				pushLoad(n);
+			}
+			nodes[n].idleUntil(target);
+			nodes[n].admit(spec, migrated);
+			next++;
+		}
+
+		target = (next < order.size()) ? workload.threads[order[next]].arrival_time : INT_MAX;
+	};
+
+	std::barrier sync(num_workers, dispatch);
+
+	/*worker w owns nodes w, w + num_workers, ... and steps them up to target, the next time a
+	thread arrives. A node that runs out of threads stops early and skips the idle time once
+	it is handed another thread*/
+	auto work = [&](int w)
+	{
+		if (options.policy == DISPATCH_ROUND_ROBIN)
+		{
+			for (int i = w; i < num_of_nodes; i += num_workers)
+			{
+				CPUSim & node = nodes[i];
+				for (int t : assigned[i])
+				{
+					while (node.clock < workload.threads[t].arrival_time && node.step())
+					{
+					}
+					node.idleUntil(workload.threads[t].arrival_time);
+					node.admit(workload.threads[t], migrated_of[t]);
+				}
+				while (node.step())
+				{
+				}
+			}
+			return;
+		}
+
+		while (true)
+		{
+			int until = target;
+
+			for (int i = w; i < num_of_nodes; i += num_workers)
+			{
+				CPUSim & node = nodes[i];
+				while (node.clock < until && node.step())
+				{
+				}
+
+				int load = nodeLoad(node);
+				if (load != loads[i])
+				{
+					loads[i] = load;
+					if (use_heap)
+					{
+						changed[w].push_back(i);
+					}
+				}
+			}
+
+			if (until == INT_MAX)
+			{
+				return;
+			}
+			sync.arrive_and_wait();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int w = 1; w < num_workers; w++)
+	{
+		workers.emplace_back(work, w);
+	}
+	work(0);
+	for (std::thread & worker : workers)
+	{
+		worker.join();
+	}
+
+	for (CPUSim & node : nodes)
+	{
+		results.nodes.push_back(makeNodeResult(node));
+	}
+	results.totals = mergeResults(nodes, workload, config.time_quantum);
+
+	return results;
+}
+
+void printClusterStats(const ClusterResults & results, const ClusterOptions & options, Flag detailed)
+{
+	const char * names[] = { "round robin", "least loaded", "power of two choices", "affinity" };
+	int total_time = results.totals.total_time;
+	int min_threads = INT_MAX;
+	int max_threads = 0;
+	float min_utilization = 1e30f;
+	float max_utilization = 0;
+
+	printf("\nCluster of %d nodes, %s dispatch:\n", (int)results.nodes.size(), names[options.policy]);
+	printDefaultStats(results.totals);
+
+	for (const NodeResult & node : results.nodes)
+	{
+		float utilization = (total_time > 0) ? ((float)node.busy_time / total_time) * 100 : 0;
+
+		min_threads = std::min(min_threads, node.num_of_threads);
+		max_threads = std::max(max_threads, node.num_of_threads);
+		min_utilization = std::min(min_utilization, utilization);
+		max_utilization = std::max(max_utilization, utilization);
+	}
+
+	printf("Threads per node: min %d, max %d\n", min_threads, max_threads);
+	printf("Node utilization: min %.0f, max %.0f percent\n\n", min_utilization, max_utilization);
+
+	if (detailed == SET)
+	{
+		for (size_t i = 0; i < results.nodes.size(); i++)
+		{
+			const NodeResult & node = results.nodes[i];
+			float utilization = (total_time > 0) ? ((float)node.busy_time / total_time) * 100 : 0;
+
+			printf("Node %zu: %d threads, total time %d, utilization %.0f percent, average turnaround %.1f\n",
+				i, node.num_of_threads, node.total_time, utilization, node.average_turnaround);
+		}
+		printf("\n");
+	}
+}
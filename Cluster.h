@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CPUSim.h"
+#include <stdint.h>
+#include <vector>
+
+#define AFFINITY_SLACK 2        /*threads a node may have over the least loaded one and still be preferred for affinity*/
+
+/*how the dispatcher picks the node of an arriving thread*/
+typedef enum DispatchPolicy {
+	DISPATCH_ROUND_ROBIN = 0,   /*nodes in turn, regardless of their load*/
+	DISPATCH_LEAST_LOADED = 1,  /*node with the fewest threads that have not exited*/
+	DISPATCH_TWO_CHOICES = 2,   /*less loaded of two nodes picked at random*/
+	DISPATCH_AFFINITY = 3       /*node the process was last sent to unless it is overloaded, least loaded otherwise*/
+} DispatchPolicy;
+
+struct ClusterOptions
+{
+	ClusterOptions()
+	{
+		num_of_nodes = 1;
+		policy = DISPATCH_ROUND_ROBIN;
+		num_workers = 0;
+		seed = 1;
+	}
+
+	int num_of_nodes;
+	DispatchPolicy policy;
+	RunConfig config;           /*run configuration of every node, verbose is ignored*/
+	int num_workers;            /*host threads, 0 for one per hardware thread*/
+	uint64_t seed;              /*random state of DISPATCH_TWO_CHOICES*/
+};
+
+/*statistics of one node of a cluster run*/
+struct NodeResult
+{
+	int num_of_threads;         /*threads dispatched to the node*/
+	int total_time;             /*time units until the last thread of the node exited*/
+	int busy_time;              /*time units the node was executing*/
+	float average_turnaround;   /*average turnaround of the threads of the node*/
+};
+
+struct ClusterResults
+{
+	SimResults totals;          /*the whole cluster, threads in exit order across all nodes*/
+	std::vector<NodeResult> nodes;
+};
+
+/*simulates the workload on num_of_nodes independent CPUSims. Every thread is handed to a
+node by the dispatcher at its arrival time and runs there until it exits.
+Nodes only interact through the dispatcher, so they are stepped in parallel on a pool of
+host threads and only synchronize at arrival times, the earliest point at which one node can
+affect another (round robin dispatch does not look at the nodes and never synchronizes).
+A thread sent to another node than the last thread of its process is admitted as migrated, which
+the affinity cost model charges for. A cluster of one node gives exactly the results of a single
+CPUSim run*/
+ClusterResults runCluster(const Workload & workload, const ClusterOptions & options);
+
+/*prints the cluster statistics, and one line per node if detailed is SET*/
+void printClusterStats(const ClusterResults & results, const ClusterOptions & options, Flag detailed);
@@ -0,0 +1,380 @@
+#include "EventLog.h"
+#include <algorithm>
+#include <string.h>
+
+static inline uint64_t threadKey(int process_number, int thread_number)
+{
+	return ((uint64_t)(uint32_t)process_number << 32) | (uint32_t)thread_number;
+}
+
+EventLog::EventLog()
+{
+	file = nullptr;
+	filled = 0;
+	events_logged = 0;
+	closing = false;
+	offset = 0;
+	failed = false;
+}
+
+EventLog::~EventLog()
+{
+	close();
+}
+
+bool EventLog::open(const char * path)
+{
+	uint32_t header[2] = { EVENT_BLOCK_EVENTS, 0 };
+
+	close();
+
+	file = fopen(path, "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	failed = fwrite(EVENT_LOG_MAGIC, 1, 8, file) != 8 || fwrite(header, sizeof(header), 1, file) != 1;
+	offset = 8 + sizeof(header);
+	current.resize(EVENT_BLOCK_EVENTS);
+	filled = 0;
+	events_logged = 0;
+	closing = false;
+	blocks.clear();
+	thread_of.clear();
+	threads.clear();
+	thread_blocks.clear();
+
+	writer = std::thread(&EventLog::work, this);
+	return true;
+}
+
+void EventLog::submit()
+{
+	PendingBlock block;
+	block.count = filled;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		block.events.swap(current);
+		pending.push_back(std::move(block));
+
+		/*reuse a written block if there is one, never wait for the writer*/
+		if (!spare.empty())
+		{
+			current.swap(spare.back());
+			spare.pop_back();
+		}
+	}
+	ready.notify_one();
+
+	if (current.size() != EVENT_BLOCK_EVENTS)
+	{
+		current.resize(EVENT_BLOCK_EVENTS);
+	}
+	events_logged += filled;
+	filled = 0;
+}
+
+void EventLog::work()
+{
+	while (true)
+	{
+		PendingBlock block;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			ready.wait(guard, [this]() { return closing || !pending.empty(); });
+			if (pending.empty())
+			{
+				return;
+			}
+			block = std::move(pending.front());
+			pending.pop_front();
+		}
+
+		writeBlock(block.events, block.count);
+
+		std::lock_guard<std::mutex> guard(lock);
+		spare.push_back(std::move(block.events));
+	}
+}
+
+void EventLog::writeBlock(const std::vector<Event> & events, size_t count)
+{
+	EventBlockIndex index;
+	uint32_t number = (uint32_t)blocks.size();
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	index.first_time = events[0].time;
+	index.last_time = events[count - 1].time;
+	index.count = (uint32_t)count;
+	index.reserved = 0;
+	index.offset = offset;
+	blocks.push_back(index);
+
+	/*a thread lists each block it has events in once*/
+	for (size_t i = 0; i < count; i++)
+	{
+		const Event & e = events[i];
+		auto found = thread_of.find(threadKey(e.process_number, e.thread_number));
+
+		if (found == thread_of.end())
+		{
+			EventThreadIndex t;
+			t.process_number = e.process_number;
+			t.thread_number = e.thread_number;
+			t.num_of_blocks = 0;
+			t.reserved = 0;
+			t.offset = 0;
+
+			found = thread_of.emplace(threadKey(e.process_number, e.thread_number), (int)threads.size()).first;
+			threads.push_back(t);
+			thread_blocks.emplace_back();
+		}
+
+		std::vector<uint32_t> & list = thread_blocks[found->second];
+		if (list.empty() || list.back() != number)
+		{
+			list.push_back(number);
+		}
+	}
+
+	if (fwrite(events.data(), sizeof(Event), count, file) != count)
+	{
+		failed = true;
+	}
+	offset += sizeof(Event) * count;
+}
+
+void EventLog::writeIndex()
+{
+	uint64_t index_offset = offset;
+	uint32_t num_of_blocks = (uint32_t)blocks.size();
+	uint32_t num_of_threads = (uint32_t)threads.size();
+
+	/*the block lists follow the directory, threads are sorted so a query can binary search*/
+	std::vector<int> order(threads.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = (int)i;
+	}
+	std::sort(order.begin(), order.end(), [this](int a, int b)
+	{
+		return threadKey(threads[a].process_number, threads[a].thread_number) < threadKey(threads[b].process_number, threads[b].thread_number);
+	});
+
+	uint64_t list_offset = index_offset + sizeof(uint32_t) + sizeof(EventBlockIndex) * num_of_blocks
+		+ sizeof(uint32_t) + sizeof(EventThreadIndex) * num_of_threads;
+	std::vector<EventThreadIndex> directory;
+	directory.reserve(threads.size());
+	for (int i : order)
+	{
+		EventThreadIndex t = threads[i];
+		t.num_of_blocks = (uint32_t)thread_blocks[i].size();
+		t.offset = list_offset;
+		list_offset += sizeof(uint32_t) * t.num_of_blocks;
+		directory.push_back(t);
+	}
+
+	bool written = fwrite(&num_of_blocks, sizeof(num_of_blocks), 1, file) == 1
+		&& fwrite(blocks.data(), sizeof(EventBlockIndex), blocks.size(), file) == blocks.size()
+		&& fwrite(&num_of_threads, sizeof(num_of_threads), 1, file) == 1
+		&& fwrite(directory.data(), sizeof(EventThreadIndex), directory.size(), file) == directory.size();
+	for (int i : order)
+	{
+		written = written && fwrite(thread_blocks[i].data(), sizeof(uint32_t), thread_blocks[i].size(), file) == thread_blocks[i].size();
+	}
+	written = written && fwrite(&index_offset, sizeof(index_offset), 1, file) == 1 && fwrite(EVENT_INDEX_MAGIC, 1, 8, file) == 8;
+
+	if (!written)
+	{
+		failed = true;
+	}
+}
+
+bool EventLog::close()
+{
+	if (file == nullptr)
+	{
+		return true;
+	}
+
+	if (filled > 0)
+	{
+		submit();
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		closing = true;
+	}
+	ready.notify_one();
+	writer.join();
+
+	writeIndex();
+	bool ok = !failed;
+	ok = (fclose(file) == 0) && ok;
+	file = nullptr;
+
+	pending.clear();
+	spare.clear();
+	return ok;
+}
+
+EventLogReader::EventLogReader()
+{
+	file = nullptr;
+}
+
+EventLogReader::~EventLogReader()
+{
+	close();
+}
+
+bool EventLogReader::open(const char * path)
+{
+	char magic[8];
+	uint64_t index_offset = 0;
+	uint32_t count = 0;
+
+	close();
+
+	file = fopen(path, "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	/*the trailer points at the index*/
+	if (fread(magic, 1, 8, file) != 8 || memcmp(magic, EVENT_LOG_MAGIC, 8) != 0
+		|| fseeko(file, -16, SEEK_END) != 0 || fread(&index_offset, sizeof(index_offset), 1, file) != 1
+		|| fread(magic, 1, 8, file) != 8 || memcmp(magic, EVENT_INDEX_MAGIC, 8) != 0
+		|| fseeko(file, (off_t)index_offset, SEEK_SET) != 0)
+	{
+		close();
+		return false;
+	}
+
+	bool ok = fread(&count, sizeof(count), 1, file) == 1;
+	if (ok)
+	{
+		blocks.resize(count);
+		ok = fread(blocks.data(), sizeof(EventBlockIndex), count, file) == count && fread(&count, sizeof(count), 1, file) == 1;
+	}
+	if (ok)
+	{
+		threads.resize(count);
+		ok = fread(threads.data(), sizeof(EventThreadIndex), count, file) == count;
+	}
+
+	if (!ok)
+	{
+		close();
+	}
+	return ok;
+}
+
+void EventLogReader::close()
+{
+	if (file != nullptr)
+	{
+		fclose(file);
+		file = nullptr;
+	}
+	blocks.clear();
+	threads.clear();
+}
+
+bool EventLogReader::readBlock(uint32_t block, std::vector<Event> & events)
+{
+	const EventBlockIndex & index = blocks[block];
+
+	events.resize(index.count);
+	return fseeko(file, (off_t)index.offset, SEEK_SET) == 0
+		&& fread(events.data(), sizeof(Event), index.count, file) == index.count;
+}
+
+std::vector<Event> EventLogReader::queryRange(int t1, int t2)
+{
+	std::vector<Event> found;
+	std::vector<Event> events;
+
+	/*first block that can hold an event at t1 or later*/
+	auto first = std::lower_bound(blocks.begin(), blocks.end(), t1,
+		[](const EventBlockIndex & b, int time) { return b.last_time < time; });
+
+	for (uint32_t b = (uint32_t)(first - blocks.begin()); b < blocks.size() && blocks[b].first_time <= t2; b++)
+	{
+		if (!readBlock(b, events))
+		{
+			break;
+		}
+		for (const Event & e : events)
+		{
+			if (e.time >= t1 && e.time <= t2)
+			{
+				found.push_back(e);
+			}
+		}
+	}
+
+	return found;
+}
+
+std::vector<Event> EventLogReader::queryThread(int process_number, int thread_number)
+{
+	std::vector<Event> found;
+	std::vector<Event> events;
+	uint64_t key = threadKey(process_number, thread_number);
+
+	auto t = std::lower_bound(threads.begin(), threads.end(), key,
+		[](const EventThreadIndex & x, uint64_t k) { return threadKey(x.process_number, x.thread_number) < k; });
+	if (t == threads.end() || threadKey(t->process_number, t->thread_number) != key)
+	{
+		return found;
+	}
+
+	std::vector<uint32_t> list(t->num_of_blocks);
+	if (fseeko(file, (off_t)t->offset, SEEK_SET) != 0 || fread(list.data(), sizeof(uint32_t), list.size(), file) != list.size())
+	{
+		return found;
+	}
+
+	for (uint32_t b : list)
+	{
+		if (b >= blocks.size() || !readBlock(b, events))
+		{
+			break;
+		}
+		for (const Event & e : events)
+		{
+			if (e.process_number == process_number && e.thread_number == thread_number)
+			{
+				found.push_back(e);
+			}
+		}
+	}
+
+	return found;
+}
+
+long long EventLogReader::getNumberOfEvents()
+{
+	long long total = 0;
+
+	for (const EventBlockIndex & b : blocks)
+	{
+		total += b.count;
+	}
+	return total;
+}
+
+void printEvent(const Event & e)
+{
+	printf("At Time %d: Thread %d of Process %d moves from %s to %s\n", e.time, e.thread_number, e.process_number,
+		threadStateName(e.from), threadStateName(e.to));
+}
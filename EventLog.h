@@ -0,0 +1,158 @@
+#pragma once
+
+#include "CPUSim.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define EVENT_BLOCK_EVENTS 4096         /*events per block of the log file, 64KB*/
+#define EVENT_LOG_MAGIC "CPUSIMV1"
+#define EVENT_INDEX_MAGIC "CPUSIMVI"
+
+/*one state transition of a thread, the record of the event log*/
+struct Event
+{
+	int32_t time;
+	int32_t process_number;
+	int32_t thread_number;
+	uint8_t from;               /*ThreadState*/
+	uint8_t to;
+	uint16_t reserved;
+};
+static_assert(sizeof(Event) == 16, "Event is written out as a 16 byte binary record");
+
+/*sparse time index, one entry per block*/
+struct EventBlockIndex
+{
+	int32_t first_time;
+	int32_t last_time;
+	uint32_t count;
+	uint32_t reserved;
+	uint64_t offset;            /*file offset of the first event of the block*/
+};
+static_assert(sizeof(EventBlockIndex) == 24, "EventBlockIndex is written out as a 24 byte binary record");
+
+/*per thread index, the blocks holding events of one thread*/
+struct EventThreadIndex
+{
+	int32_t process_number;
+	int32_t thread_number;
+	uint32_t num_of_blocks;
+	uint32_t reserved;
+	uint64_t offset;            /*file offset of num_of_blocks uint32 block numbers*/
+};
+static_assert(sizeof(EventThreadIndex) == 24, "EventThreadIndex is written out as a 24 byte binary record");
+
+/*writes every state transition of a run to a binary log that can be queried without a rescan.
+
+The file is the 8 byte magic "CPUSIMV1" and uint32 EVENT_BLOCK_EVENTS, uint32 0, followed by
+blocks of EVENT_BLOCK_EVENTS Events (the last one may be short) in time order, then the index:
+uint32 block count and one EventBlockIndex per block, uint32 thread count and one
+EventThreadIndex per thread sorted by process and thread number, the uint32 block lists of the
+threads, and finally the uint64 offset of the index and the magic "CPUSIMVI".
+
+add() only copies the event into a block, full blocks are written and indexed by a
+background thread, so the simulation never waits for the disk. Buffers of blocks the writer
+has not got to yet are allocated as needed rather than waited for*/
+class EventLog
+{
+public:
+	EventLog();
+	~EventLog();
+
+	/*opens path for writing and starts the writer thread, returns false if it can not be created*/
+	bool open(const char * path);
+
+	void add(int time, int process_number, int thread_number, ThreadState from, ThreadState to)
+	{
+		Event & e = current[filled++];
+		e.time = time;
+		e.process_number = process_number;
+		e.thread_number = thread_number;
+		e.from = (uint8_t)from;
+		e.to = (uint8_t)to;
+		e.reserved = 0;
+
+		if (filled == EVENT_BLOCK_EVENTS)
+		{
+			submit();
+		}
+	}
+
+	/*writes the last block and the index and closes the file, returns false if a write failed*/
+	bool close();
+
+	long long getEventsLogged()
+	{
+		return events_logged + filled;
+	}
+
+private:
+	/*a block on its way to the writer thread*/
+	struct PendingBlock
+	{
+		std::vector<Event> events;
+		size_t count;
+	};
+
+	void submit();
+	void work();
+	void writeBlock(const std::vector<Event> & events, size_t count);
+	void writeIndex();
+
+	FILE * file;
+	std::vector<Event> current;         /*block being filled by add()*/
+	size_t filled;
+	long long events_logged;            /*events in submitted blocks*/
+
+	std::mutex lock;
+	std::condition_variable ready;
+	std::deque<PendingBlock> pending;
+	std::vector<std::vector<Event>> spare;  /*written blocks, reused by submit()*/
+	bool closing;
+	std::thread writer;
+
+	/*owned by the writer thread until it has finished*/
+	uint64_t offset;
+	bool failed;
+	std::vector<EventBlockIndex> blocks;
+	std::unordered_map<uint64_t, int> thread_of;    /*(process, thread) to position in threads*/
+	std::vector<EventThreadIndex> threads;
+	std::vector<std::vector<uint32_t>> thread_blocks;
+};
+
+/*answers queries on an event log. Only the index is read on open, a query reads just the
+blocks it needs*/
+class EventLogReader
+{
+public:
+	EventLogReader();
+	~EventLogReader();
+
+	/*reads the index of the log at path, returns false if it is not a complete event log*/
+	bool open(const char * path);
+	void close();
+
+	/*every event with t1 <= time <= t2, in log order*/
+	std::vector<Event> queryRange(int t1, int t2);
+
+	/*every event of thread thread_number of process process_number, in log order*/
+	std::vector<Event> queryThread(int process_number, int thread_number);
+
+	long long getNumberOfEvents();
+
+private:
+	bool readBlock(uint32_t block, std::vector<Event> & events);
+
+	FILE * file;
+	std::vector<EventBlockIndex> blocks;
+	std::vector<EventThreadIndex> threads;
+};
+
+/*prints an event as the line -v prints for it*/
+void printEvent(const Event & e);
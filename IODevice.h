@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#define IO_UNLIMITED_CHANNELS 0
+
+/*how a device serves the io bursts sent to it*/
+typedef enum IODiscipline {
+	IO_FIFO = 0,                /*one burst at a time, the rest wait in arrival order*/
+	IO_PARALLEL = 1             /*up to channels bursts at a time, the rest wait in arrival order*/
+} IODiscipline;
+
+struct IODeviceConfig
+{
+	IODeviceConfig()
+	{
+		discipline = IO_PARALLEL;
+		channels = IO_UNLIMITED_CHANNELS;
+	}
+
+	IODiscipline discipline;
+	int channels;               /*bursts served at once by IO_PARALLEL, IO_UNLIMITED_CHANNELS for no limit*/
+};
+
+/*an io device of a CPUSim. Blocked threads are either in service, held in a heap ordered by
+completion time, or waiting for a channel in arrival order. Only the bursts that complete
+are ever looked at, so a tick costs nothing per blocked thread. Bursts completing at the same
+time complete in the order they started in, then arrived in, on any device, so devices with
+unlimited channels are exactly the old io queue where every blocked thread counts down on its own*/
+class IODevice
+{
+public:
+	IODevice()
+	{
+		configure(IODeviceConfig());
+	}
+
+	void configure(const IODeviceConfig & c)
+	{
+		config = c;
+		channels = (c.discipline == IO_FIFO) ? 1 : c.channels;
+		clear();
+	}
+
+	IODeviceConfig getConfig() const
+	{
+		return config;
+	}
+
+	void clear()
+	{
+		in_service.clear();
+		waiting.clear();
+		next_sequence = 0;
+		busy_since = 0;
+		requests = 0;
+		busy_time = 0;
+		total_wait = 0;
+		max_wait = 0;
+	}
+
+	/*thread index blocks on the device at time for io_time time units*/
+	void request(int index, int io_time, int time)
+	{
+		Request r;
+		r.index = index;
+		r.io_time = io_time;
+		r.arrival_time = time;
+
+		requests++;
+		if (channels == IO_UNLIMITED_CHANNELS || (int)in_service.size() < channels)
+		{
+			start(r, time);
+		}
+		else
+		{
+			waiting.push_back(r);
+		}
+	}
+
+	/*true if a burst completed at or before time*/
+	bool completedBy(int time)
+	{
+		return !in_service.empty() && in_service.front().time <= time;
+	}
+
+	/*true if the next burst to complete on this device completes before the one of other*/
+	bool completesBefore(const IODevice & other)
+	{
+		return later(other.in_service.front(), in_service.front());
+	}
+
+	/*takes the next burst to complete, starts the burst waiting for its channel and returns
+	the thread index of the burst, completedBy must be true*/
+	int complete()
+	{
+		std::pop_heap(in_service.begin(), in_service.end(), later);
+		Completion done = in_service.back();
+		in_service.pop_back();
+
+		if (in_service.empty())
+		{
+			busy_time += done.time - busy_since;
+		}
+
+		/*the freed channel goes to the longest waiting burst*/
+		if (!waiting.empty())
+		{
+			Request r = waiting.front();
+			waiting.pop_front();
+			start(r, done.time);
+		}
+
+		return done.index;
+	}
+
+	/*threads blocked on the device, in service or waiting*/
+	int size()
+	{
+		return (int)(in_service.size() + waiting.size());
+	}
+
+public:
+	long long requests;         /*io bursts sent to the device*/
+	long long busy_time;        /*time units with at least one burst in service*/
+	long long total_wait;       /*time units bursts spent waiting for a channel*/
+	int max_wait;               /*longest a burst waited for a channel*/
+
+private:
+	struct Request
+	{
+		int index;
+		int io_time;
+		int arrival_time;
+	};
+
+	struct Completion
+	{
+		int time;
+		int start_time;
+		int arrival_time;
+		long long sequence;     /*order the bursts started in on this device*/
+		int index;
+	};
+
+	/*heap order, the earliest completion is at the front*/
+	static bool later(const Completion & a, const Completion & b)
+	{
+		if (a.time != b.time)
+		{
+			return a.time > b.time;
+		}
+		if (a.start_time != b.start_time)
+		{
+			return a.start_time > b.start_time;
+		}
+		if (a.arrival_time != b.arrival_time)
+		{
+			return a.arrival_time > b.arrival_time;
+		}
+		return a.sequence > b.sequence;
+	}
+
+	void start(const Request & r, int time)
+	{
+		Completion c;
+		c.time = time + r.io_time;
+		c.start_time = time;
+		c.arrival_time = r.arrival_time;
+		c.sequence = next_sequence++;
+		c.index = r.index;
+
+		if (in_service.empty())
+		{
+			busy_since = time;
+		}
+		in_service.push_back(c);
+		std::push_heap(in_service.begin(), in_service.end(), later);
+
+		total_wait += time - r.arrival_time;
+		max_wait = std::max(max_wait, time - r.arrival_time);
+	}
+
+	IODeviceConfig config;
+	int channels;               /*bursts in service at once, IO_UNLIMITED_CHANNELS for no limit*/
+	std::vector<Completion> in_service;
+	std::deque<Request> waiting;
+	long long next_sequence;
+	int busy_since;             /*time the device last went from idle to busy*/
+};
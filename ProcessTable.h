@@ -0,0 +1,53 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+/*maps process numbers, which need not be dense or start at 1, to dense indices
+0..size()-1 in order of first appearance. Workloads fill it as they are parsed so the
+simulator only ever deals with indices*/
+class ProcessTable
+{
+public:
+	/*returns the index of process_number, adding it if it is new*/
+	int add(int process_number)
+	{
+		auto found = index_of.find(process_number);
+
+		if (found != index_of.end())
+		{
+			return found->second;
+		}
+
+		index_of.emplace(process_number, (int)numbers.size());
+		numbers.push_back(process_number);
+		return (int)numbers.size() - 1;
+	}
+
+	/*index of process_number, -1 if it is not in the table*/
+	int find(int process_number) const
+	{
+		auto found = index_of.find(process_number);
+		return (found != index_of.end()) ? found->second : -1;
+	}
+
+	int getProcessNumber(int index) const
+	{
+		return numbers[index];
+	}
+
+	int size() const
+	{
+		return (int)numbers.size();
+	}
+
+	void clear()
+	{
+		index_of.clear();
+		numbers.clear();
+	}
+
+private:
+	std::unordered_map<int, int> index_of;
+	std::vector<int> numbers;   /*process number of every index*/
+};
@@ -0,0 +1,199 @@
+#include "ResultCache.h"
+#include <atomic>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+/*fixed size part of a cache file*/
+struct CacheHeader
+{
+	char magic[8];
+	uint64_t key;
+	int engine_version;
+	int time_quantum;
+	int total_time;
+	float average_turnaround;
+	float cpu_utilization;
+	int num_of_threads;
+};
+
+/*combines v into the hash h*/
+static inline uint64_t mix(uint64_t h, uint64_t v)
+{
+	h ^= v;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t pack(int a, int b)
+{
+	return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+static inline uint64_t mixBurst(uint64_t h, Burst burst)
+{
+	h = mix(h, pack(burst.get_cpu_time(), burst.get_io_time()));
+	if (burst.get_device() != 0)
+	{
+		h = mix(h, pack(burst.get_device(), 1));
+	}
+	return h;
+}
+
+uint64_t hashWorkload(const Workload & workload)
+{
+	uint64_t h = 0x6A09E667F3BCC909ULL;
+
+	h = mix(h, pack(workload.num_of_processes, (int)workload.threads.size()));
+	h = mix(h, pack(workload.thread_switch, workload.process_switch));
+
+	for (const ThreadSpec & spec : workload.threads)
+	{
+		if (spec.program != nullptr)
+		{
+			return 0;
+		}
+
+		h = mix(h, pack(spec.process_number, spec.thread_number));
+		/*plain and compressed bursts hash the same, so compressing a workload keeps its key*/
+		h = mix(h, pack(spec.arrival_time, (int)spec.bursts.size() + spec.encoded.getCount()));
+		for (Burst burst : spec.bursts)
+		{
+			h = mixBurst(h, burst);
+		}
+		for (BurstCursor cursor = spec.encoded; cursor.hasNext();)
+		{
+			h = mixBurst(h, cursor.next());
+		}
+
+		if (spec.generator.getCount() > 0)
+		{
+			BurstDistribution cpu = spec.generator.getCPUDistribution();
+			BurstDistribution io = spec.generator.getIODistribution();
+			h = mix(h, pack(spec.generator.getCount(), cpu.type));
+			h = mix(h, pack(cpu.a, cpu.b));
+			h = mix(h, pack(io.type, io.a));
+			h = mix(h, pack(io.b, 0));
+			h = mix(h, spec.generator.getState());
+		}
+	}
+
+	/*final avalanche*/
+	h = mix(h, h >> 29);
+	return h;
+}
+
+uint64_t resultKey(const Workload & workload, const RunConfig & config)
+{
+	uint64_t h = hashWorkload(workload);
+
+	if (h == 0)
+	{
+		return 0;
+	}
+
+	h = mix(h, pack(config.time_quantum, config.round_robin));
+	h = mix(h, pack(config.thread_switch >= 0 ? config.thread_switch : workload.thread_switch,
+		config.process_switch >= 0 ? config.process_switch : workload.process_switch));
+	if (config.affinity == SET)
+	{
+		h = mix(h, pack(config.warm_switch, config.cold_switch));
+		h = mix(h, pack(config.migration_switch, AFFINITY_SET_SIZE));
+	}
+	for (const IODeviceConfig & device : config.io_devices)
+	{
+		h = mix(h, pack(device.discipline, device.channels));
+	}
+	h = mix(h, pack(ENGINE_VERSION, 0));
+	return h != 0 ? h : 1;
+}
+
+ResultCache::ResultCache(const char * dir)
+{
+	directory = dir;
+	mkdir(dir, 0777);
+}
+
+std::string ResultCache::pathFor(uint64_t key)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "/%016llx.res", (unsigned long long)key);
+	return directory + name;
+}
+
+bool ResultCache::lookup(uint64_t key, SimResults & results)
+{
+	CacheHeader header;
+	struct stat info;
+	FILE * file = fopen(pathFor(key).c_str(), "rb");
+	bool found = false;
+
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	/*the thread count must match the size of the file before anything is allocated for it,
+	a truncated or corrupt entry is a miss*/
+	if (fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, RESULT_CACHE_MAGIC, 8) == 0
+		&& header.key == key && header.engine_version == ENGINE_VERSION && header.num_of_threads >= 0
+		&& fstat(fileno(file), &info) == 0
+		&& (uint64_t)info.st_size == sizeof(header) + (uint64_t)header.num_of_threads * sizeof(ThreadResult))
+	{
+		results.time_quantum = header.time_quantum;
+		results.total_time = header.total_time;
+		results.average_turnaround = header.average_turnaround;
+		results.cpu_utilization = header.cpu_utilization;
+		results.threads.resize(header.num_of_threads);
+
+		found = fread(results.threads.data(), sizeof(ThreadResult), header.num_of_threads, file) == (size_t)header.num_of_threads;
+	}
+
+	fclose(file);
+	return found;
+}
+
+bool ResultCache::store(uint64_t key, const SimResults & results)
+{
+	static std::atomic<unsigned> counter(0);
+	CacheHeader header;
+	char suffix[64];
+	std::string path = pathFor(key);
+
+	/*unique per process, thread and call*/
+	snprintf(suffix, sizeof(suffix), ".tmp.%d.%zx.%u", (int)getpid(), std::hash<std::thread::id>()(std::this_thread::get_id()), counter++);
+	std::string temp = path + suffix;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RESULT_CACHE_MAGIC, 8);
+	header.key = key;
+	header.engine_version = ENGINE_VERSION;
+	header.time_quantum = results.time_quantum;
+	header.total_time = results.total_time;
+	header.average_turnaround = results.average_turnaround;
+	header.cpu_utilization = results.cpu_utilization;
+	header.num_of_threads = (int)results.threads.size();
+
+	FILE * file = fopen(temp.c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(results.threads.data(), sizeof(ThreadResult), results.threads.size(), file) == results.threads.size();
+	written = (fclose(file) == 0) && written;
+
+	/*rename is atomic, readers never see a partly written file*/
+	if (!written || rename(temp.c_str(), path.c_str()) != 0)
+	{
+		unlink(temp.c_str());
+		return false;
+	}
+	return true;
+}
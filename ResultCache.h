@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CPUSim.h"
+#include <stdint.h>
+#include <string>
+
+#define RESULT_CACHE_MAGIC "CPUSIMC1"
+
+/*64 bit hash of everything in a workload that affects a run. Workloads with coroutine
+program threads can not be hashed (a function address means nothing in another process)
+and hash to 0*/
+uint64_t hashWorkload(const Workload & workload);
+
+/*cache key of running workload under config, 0 if the run can not be cached*/
+uint64_t resultKey(const Workload & workload, const RunConfig & config);
+
+/*on disk cache of SimResults, one file per key in a directory.
+Files are written to a unique temporary name and renamed into place, so any number of
+processes can share the directory: a reader sees either a complete file or none, and two
+writers of the same key just replace one complete file with an identical one*/
+class ResultCache
+{
+public:
+	ResultCache(const char * dir);
+
+	/*fills results and returns true if key is in the cache*/
+	bool lookup(uint64_t key, SimResults & results);
+
+	/*stores results under key, returns false if the file could not be written*/
+	bool store(uint64_t key, const SimResults & results);
+
+private:
+	std::string pathFor(uint64_t key);
+
+	std::string directory;
+};
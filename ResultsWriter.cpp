@@ -0,0 +1,219 @@
+#include "ResultsWriter.h"
+#include "CPUSim.h"
+#include <string.h>
+
+ResultsWriter::ResultsWriter()
+{
+	file = nullptr;
+	format = RESULTS_CSV;
+	buffered = 0;
+	block_rows = 0;
+	rows_written = 0;
+	failed = false;
+}
+
+ResultsWriter::~ResultsWriter()
+{
+	close();
+}
+
+bool ResultsWriter::open(const char * path, ResultsFormat fmt)
+{
+	int num_columns = RESULTS_COLUMNS;
+
+	close();
+
+	file = fopen(path, "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	format = fmt;
+	buffer.resize(RESULTS_BUFFER_SIZE);
+	buffered = 0;
+	block_rows = 0;
+	rows_written = 0;
+	failed = false;
+
+	if (format == RESULTS_CSV)
+	{
+		const char * header = "pid,tid,arrival,start,exit,service,io,turnaround\n";
+		writeBytes(header, strlen(header));
+	}
+	else
+	{
+		columns.resize(RESULTS_COLUMNS * RESULTS_BLOCK_ROWS);
+		writeBytes(RESULTS_MAGIC, 8);
+		writeBytes(&num_columns, sizeof(num_columns));
+	}
+
+	return true;
+}
+
+void ResultsWriter::addThread(const ThreadResult & r)
+{
+	int row[RESULTS_COLUMNS] = { r.process_number, r.thread_number, r.arrival_time, r.start_time,
+		r.exit_time, r.service_time, r.io_time, r.turnaround_time };
+
+	if (file == nullptr)
+	{
+		return;
+	}
+
+	if (format == RESULTS_CSV)
+	{
+		for (int c = 0; c < RESULTS_COLUMNS; c++)
+		{
+			writeInt(row[c]);
+			buffer[buffered++] = (c == RESULTS_COLUMNS - 1) ? '\n' : ',';
+		}
+	}
+	else
+	{
+		/*the row is scattered into the columns of the current block*/
+		for (int c = 0; c < RESULTS_COLUMNS; c++)
+		{
+			columns[c * RESULTS_BLOCK_ROWS + block_rows] = row[c];
+		}
+		if (++block_rows == RESULTS_BLOCK_ROWS)
+		{
+			flushBlock();
+		}
+	}
+
+	rows_written++;
+}
+
+bool ResultsWriter::close()
+{
+	int end_of_file = 0;
+
+	if (file == nullptr)
+	{
+		return true;
+	}
+
+	if (format == RESULTS_BINARY)
+	{
+		flushBlock();
+		writeBytes(&end_of_file, sizeof(end_of_file));
+	}
+	flushBuffer();
+
+	bool ok = !failed;
+	ok = (fclose(file) == 0) && ok;
+	file = nullptr;
+	return ok;
+}
+
+void ResultsWriter::writeInt(int value)
+{
+	char digits[12];
+	int n = 0;
+	unsigned int u = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+	/*a row never needs more than 8 * 12 bytes*/
+	if (buffered + 12 >= buffer.size())
+	{
+		flushBuffer();
+	}
+
+	do
+	{
+		digits[n++] = (char)('0' + u % 10);
+		u /= 10;
+	} while (u != 0);
+
+	if (value < 0)
+	{
+		buffer[buffered++] = '-';
+	}
+	while (n > 0)
+	{
+		buffer[buffered++] = digits[--n];
+	}
+}
+
+void ResultsWriter::writeBytes(const void * data, size_t len)
+{
+	const char * p = (const char *)data;
+
+	while (len > 0)
+	{
+		size_t n = buffer.size() - buffered;
+		if (n > len)
+		{
+			n = len;
+		}
+		memcpy(buffer.data() + buffered, p, n);
+		buffered += n;
+		p += n;
+		len -= n;
+
+		if (buffered == buffer.size())
+		{
+			flushBuffer();
+		}
+	}
+}
+
+void ResultsWriter::flushBlock()
+{
+	if (block_rows == 0)
+	{
+		return;
+	}
+
+	writeBytes(&block_rows, sizeof(block_rows));
+	for (int c = 0; c < RESULTS_COLUMNS; c++)
+	{
+		writeBytes(&columns[c * RESULTS_BLOCK_ROWS], sizeof(int) * block_rows);
+	}
+	block_rows = 0;
+}
+
+void ResultsWriter::flushBuffer()
+{
+	if (buffered > 0)
+	{
+		if (fwrite(buffer.data(), 1, buffered, file) != buffered)
+		{
+			failed = true;
+		}
+		buffered = 0;
+	}
+}
+
+/*picks the format from the file extension, ".csv" is CSV and anything else is binary*/
+ResultsFormat resultsFormatForPath(const char * path)
+{
+	size_t len = strlen(path);
+
+	if (len >= 4 && strcmp(path + len - 4, ".csv") == 0)
+	{
+		return RESULTS_CSV;
+	}
+	return RESULTS_BINARY;
+}
+
+bool writeProcessResults(const char * path, const SimResults & results)
+{
+	FILE * out = fopen(path, "wb");
+
+	if (out == nullptr)
+	{
+		return false;
+	}
+
+	/*a large stdio buffer, there is one short line per process*/
+	setvbuf(out, nullptr, _IOFBF, RESULTS_BUFFER_SIZE);
+	fputs("pid,threads,first_arrival,last_exit,service,io,switches,turnaround\n", out);
+	for (const ProcessResult & p : results.processes)
+	{
+		fprintf(out, "%d,%d,%d,%d,%d,%d,%d,%d\n", p.process_number, p.num_of_threads, p.first_arrival,
+			p.last_exit, p.service_time, p.io_time, p.switches, p.turnaround_time);
+	}
+
+	return fclose(out) == 0;
+}
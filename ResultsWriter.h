@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+#define RESULTS_BUFFER_SIZE (1 << 20)   /*bytes buffered before a write to the results file*/
+#define RESULTS_BLOCK_ROWS 65536        /*rows per column block in the binary format*/
+#define RESULTS_COLUMNS 8
+#define RESULTS_MAGIC "CPUSIMR1"
+
+struct ThreadResult;
+struct SimResults;
+
+/*layout of the per thread results file*/
+typedef enum ResultsFormat {
+	RESULTS_CSV = 0,        /*header line + one line per thread*/
+	RESULTS_BINARY = 1      /*packed little endian int32 columns, see below*/
+} ResultsFormat;
+
+/*writes one row per thread as threads exit, columns are
+pid, tid, arrival, start, exit, service, io, turnaround.
+
+The binary format is the 8 byte magic "CPUSIMR1" and an int32 column count,
+followed by blocks of up to RESULTS_BLOCK_ROWS rows. A block is an int32 row count
+followed by each column as row count contiguous int32 values, in the column order above.
+A block with a row count of 0 ends the file*/
+class ResultsWriter
+{
+public:
+	ResultsWriter();
+	~ResultsWriter();
+
+	/*opens path for writing, returns false if it can not be created*/
+	bool open(const char * path, ResultsFormat fmt);
+
+	/*appends the row of one exited thread*/
+	void addThread(const ThreadResult & r);
+
+	/*flushes everything buffered and closes the file, returns false if a write failed*/
+	bool close();
+
+	bool isOpen()
+	{
+		return file != nullptr;
+	}
+
+	long long getRowsWritten()
+	{
+		return rows_written;
+	}
+
+private:
+	void writeInt(int value);
+	void writeBytes(const void * data, size_t len);
+	void flushBlock();
+	void flushBuffer();
+
+	FILE * file;
+	ResultsFormat format;
+	std::vector<char> buffer;           /*output waiting to be written*/
+	size_t buffered;
+	std::vector<int> columns;           /*binary format: RESULTS_COLUMNS columns of RESULTS_BLOCK_ROWS values*/
+	int block_rows;                     /*rows in the current binary block*/
+	long long rows_written;
+	bool failed;                        /*a write to the file came up short*/
+};
+
+/*picks the format from the file extension, ".csv" is CSV and anything else is binary*/
+ResultsFormat resultsFormatForPath(const char * path);
+
+/*writes the per process statistics of results as CSV, one line per process in process table
+order, columns pid, threads, first_arrival, last_exit, service, io, switches, turnaround.
+Returns false if path can not be written*/
+bool writeProcessResults(const char * path, const SimResults & results);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#define MIN_RING_CAPACITY 16
+
+/*growable FIFO of thread indices stored contiguously in a power of two ring,
+used as the ready queue for FCFS and RR where threads only ever enter at the back
+and leave from the front. Once the capacity covers the most threads the queue ever
+holds, pushing and popping never allocate*/
+class RingQueue
+{
+public:
+	RingQueue()
+	{
+		head = 0;
+		count = 0;
+		mask = 0;
+	}
+
+	void push(int index)
+	{
+		if (count == buffer.size())
+		{
+			grow(count + 1);
+		}
+		buffer[(head + count) & mask] = index;
+		count++;
+	}
+
+	/*removes and returns the index at the front, the queue must not be empty*/
+	int pop()
+	{
+		int index = buffer[head];
+		head = (head + 1) & mask;
+		count--;
+		return index;
+	}
+
+	int front()
+	{
+		return buffer[head];
+	}
+
+	bool empty()
+	{
+		return count == 0;
+	}
+
+	int size()
+	{
+		return (int)count;
+	}
+
+	void clear()
+	{
+		head = 0;
+		count = 0;
+	}
+
+	/*makes room for n indices up front so that later pushes do not allocate*/
+	void reserve(size_t n)
+	{
+		if (n > buffer.size())
+		{
+			grow(n);
+		}
+	}
+
+	/*index at position i from the front*/
+	int at(size_t i)
+	{
+		return buffer[(head + i) & mask];
+	}
+
+private:
+	void grow(size_t n)
+	{
+		size_t capacity = buffer.empty() ? MIN_RING_CAPACITY : buffer.size();
+		std::vector<int> larger;
+
+		while (capacity < n)
+		{
+			capacity *= 2;
+		}
+		larger.resize(capacity);
+
+		/*unwrap the ring so the front lands at position 0*/
+		for (size_t i = 0; i < count; i++)
+		{
+			larger[i] = buffer[(head + i) & mask];
+		}
+		buffer.swap(larger);
+		head = 0;
+		mask = capacity - 1;
+	}
+
+	std::vector<int> buffer;    /*capacity is always a power of two*/
+	size_t head;                /*position of the front index*/
+	size_t count;               /*indices currently queued*/
+	size_t mask;                /*capacity - 1*/
+};
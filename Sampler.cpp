@@ -0,0 +1,119 @@
+#include "Sampler.h"
+#include "CPUSim.h"
+#include <climits>
+
+Sampler::Sampler()
+{
+	file = nullptr;
+	format = RESULTS_CSV;
+	interval = DEFAULT_SAMPLE_INTERVAL;
+	next_time = INT_MAX;
+	last_time = 0;
+	last_cpu_time = 0;
+	last_switches = 0;
+	buffered = 0;
+}
+
+Sampler::~Sampler()
+{
+	close();
+}
+
+bool Sampler::open(const char * path, ResultsFormat fmt, int sample_interval)
+{
+	close();
+
+	file = fopen(path, "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	format = fmt;
+	interval = sample_interval > 0 ? sample_interval : DEFAULT_SAMPLE_INTERVAL;
+	next_time = interval;
+	last_time = 0;
+	last_cpu_time = 0;
+	last_switches = 0;
+	buffer.resize(SAMPLE_BUFFER_SIZE);
+	buffered = 0;
+
+	if (format == RESULTS_CSV)
+	{
+		fputs("time,utilization,ready,io,switches\n", file);
+	}
+	else
+	{
+		fwrite(SAMPLE_MAGIC, 1, 8, file);
+	}
+
+	return true;
+}
+
+void Sampler::sample(CPUSim & cpu)
+{
+	record(cpu, cpu.clock, interval);
+	next_time += interval;
+}
+
+void Sampler::finish(CPUSim & cpu)
+{
+	int end = cpu.clock - 1; /*one extra clock tick upon exit, as in getResults*/
+
+	if (file != nullptr && end > last_time)
+	{
+		record(cpu, end, end - last_time);
+	}
+	next_time = INT_MAX;
+}
+
+void Sampler::record(CPUSim & cpu, int time, int interval_length)
+{
+	Sample & s = buffer[buffered++];
+
+	s.time = time;
+	s.utilization = ((float)(cpu.total_cpu_execution_time - last_cpu_time) / interval_length) * 100;
+	s.ready_depth = cpu.ready_queue.size();
+	s.io_depth = cpu.getIODepth();
+	s.context_switches = cpu.context_switches - last_switches;
+
+	last_time = time;
+	last_cpu_time = cpu.total_cpu_execution_time;
+	last_switches = cpu.context_switches;
+
+	if (buffered == buffer.size())
+	{
+		flush();
+	}
+}
+
+void Sampler::flush()
+{
+	if (format == RESULTS_CSV)
+	{
+		for (size_t i = 0; i < buffered; i++)
+		{
+			Sample & s = buffer[i];
+			fprintf(file, "%d,%.1f,%d,%d,%d\n", s.time, s.utilization, s.ready_depth, s.io_depth, s.context_switches);
+		}
+	}
+	else
+	{
+		/*a Sample is laid out exactly like a binary record*/
+		fwrite(buffer.data(), sizeof(Sample), buffered, file);
+	}
+	buffered = 0;
+}
+
+void Sampler::close()
+{
+	if (file == nullptr)
+	{
+		return;
+	}
+
+	flush();
+	fclose(file);
+	file = nullptr;
+	next_time = INT_MAX;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ResultsWriter.h"
+#include <stdio.h>
+#include <vector>
+
+#define DEFAULT_SAMPLE_INTERVAL 100     /*time units per sample*/
+#define SAMPLE_BUFFER_SIZE 4096         /*samples held before they are written out*/
+#define SAMPLE_MAGIC "CPUSIMS1"
+
+class CPUSim;
+
+/*one interval of simulated time*/
+struct Sample
+{
+	int time;                   /*end of the interval*/
+	float utilization;          /*percent of the interval the cpu was executing*/
+	int ready_depth;            /*threads in the ready queue at the end of the interval*/
+	int io_depth;               /*threads in the io queue at the end of the interval*/
+	int context_switches;       /*thread and process switches started in the interval*/
+};
+static_assert(sizeof(Sample) == 20, "Sample is written out as a 20 byte binary record");
+
+/*records a Sample every interval time units of a run. Samples are taken from the
+running totals of the CPUSim at interval boundaries, so taking one costs the same
+whatever happened inside the interval, and they are collected in a buffer allocated
+up front that is written out SAMPLE_BUFFER_SIZE samples at a time.
+The binary format is the 8 byte magic "CPUSIMS1" followed by one 20 byte record per
+sample: int32 time, float utilization, int32 ready_depth, io_depth, context_switches*/
+class Sampler
+{
+public:
+	Sampler();
+	~Sampler();
+
+	/*opens path for writing, returns false if it can not be created*/
+	bool open(const char * path, ResultsFormat fmt, int sample_interval);
+
+	/*time at which the next sample is due*/
+	int getNextSampleTime()
+	{
+		return next_time;
+	}
+
+	/*records the interval ending at cpu.clock*/
+	void sample(CPUSim & cpu);
+
+	/*records the partial interval at the end of a run*/
+	void finish(CPUSim & cpu);
+
+	/*writes out the buffered samples and closes the file*/
+	void close();
+
+	bool isOpen()
+	{
+		return file != nullptr;
+	}
+
+private:
+	void record(CPUSim & cpu, int time, int interval_length);
+	void flush();
+
+	FILE * file;
+	ResultsFormat format;
+	int interval;
+	int next_time;              /*end of the current interval*/
+	int last_time;              /*start of the current interval*/
+	int last_cpu_time;          /*cpu execution time at the start of the interval*/
+	int last_switches;          /*context switches at the start of the interval*/
+	std::vector<Sample> buffer;
+	size_t buffered;
+};
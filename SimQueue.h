@@ -29,41 +29,21 @@ public:
 
 	std::shared_ptr<Thread> removeThreadAtTime(int time)
 	{
-		for (auto p : q)
+		for (auto it = q.begin(); it != q.end(); ++it)
 		{
-			if (p->getArrivalTime() == time)
+			if ((*it)->getArrivalTime() == time)
 			{
-				q.remove(p);
+				std::shared_ptr<Thread> p = *it;
+				q.erase(it);
 				return p;
 			}
 		}
 		return nullptr;
 	}
 
-	std::shared_ptr<Thread> removeIOThreadAtTime(int io_time_finished)
-	{
-		for (auto p : q)
-		{
-			if (p->getIOTimeRemaining() == io_time_finished)
-			{
-				q.remove(p);
-				return p;
-			}
-		}
-		return nullptr;
-	}
-
-	void decrementAllIO()
-	{
-		for (auto p : q)
-		{
-			p->decrement();
-		}
-	}
-
 	void print()
 	{
-		for (auto p : q)
+		for (auto & p : q)
 		{
 			p->print();
 		}
@@ -74,6 +54,11 @@ public:
 		return q.size();
 	}
 
+	void clear()
+	{
+		q.clear();
+	}
+
 public:
 	std::list<std::shared_ptr<Thread>> q;
 };
\ No newline at end of file
@@ -0,0 +1,510 @@
+#include "SimServer.h"
+#include "WorkloadFile.h"
+#include <deque>
+#include <set>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*microseconds on the steady clock*/
+static long long nowMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*quotes s as a JSON string*/
+static std::string jsonString(const std::string & s)
+{
+	std::string out = "\"";
+
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out += escaped;
+		}
+		else
+		{
+			out += c;
+		}
+	}
+	return out + "\"";
+}
+
+static std::string errorReply(const std::string & message)
+{
+	return "{\"ok\":false,\"error\":" + jsonString(message) + "}";
+}
+
+/*writes all of data to fd, returns false if the peer went away*/
+static bool sendAll(int fd, const std::string & data)
+{
+	size_t sent = 0;
+
+	while (sent < data.size())
+	{
+		ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (n <= 0)
+		{
+			return false;
+		}
+		sent += (size_t)n;
+	}
+	return true;
+}
+
+RunPool::RunPool(int num_workers)
+{
+	stopping = false;
+
+	if (num_workers <= 0)
+	{
+		num_workers = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	for (int i = 0; i < num_workers; i++)
+	{
+		workers.emplace_back(&RunPool::work, this);
+	}
+}
+
+RunPool::~RunPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	ready.notify_all();
+
+	for (std::thread & worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void RunPool::submit(std::function<void(CPUSim &)> job)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push(std::move(job));
+	}
+	ready.notify_one();
+}
+
+void RunPool::work()
+{
+	CPUSim cpu;
+
+	while (true)
+	{
+		std::function<void(CPUSim &)> job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			ready.wait(guard, [this]() { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+			{
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+		job(cpu);
+	}
+}
+
+SimServer::SimServer(int num_workers) : pool(num_workers)
+{
+	stopping = false;
+	listen_fd = -1;
+	started = std::chrono::steady_clock::now();
+	requests = 0;
+	runs = 0;
+	errors = 0;
+	total_run_us = 0;
+	total_latency_us = 0;
+	simulated_ticks = 0;
+}
+
+bool SimServer::loadWorkload(const std::string & id, const std::string & path)
+{
+	auto workload = std::make_shared<Workload>();
+
+	if (parseWorkloadFile(path.c_str(), *workload, pool.getNumberOfWorkers()) < 0)
+	{
+		return false;
+	}
+
+	std::unique_lock<std::shared_mutex> guard(workloads_lock);
+	workloads[id] = workload;
+	return true;
+}
+
+int SimServer::serve(const char * path)
+{
+	struct sockaddr_un address;
+	struct stat existing;
+	struct stat created;
+	std::set<int> connections;
+	std::mutex connections_lock;
+	std::condition_variable connections_done;
+
+	if (strlen(path) >= sizeof(address.sun_path))
+	{
+		return -1;
+	}
+
+	/*a socket left behind by an earlier server is replaced, anything else at path is kept*/
+	if (lstat(path, &existing) == 0)
+	{
+		if (!S_ISSOCK(existing.st_mode))
+		{
+			return -2;
+		}
+		unlink(path);
+	}
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0)
+	{
+		return -1;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || lstat(path, &created) != 0
+		|| listen(listen_fd, SERVER_BACKLOG) != 0)
+	{
+		close(listen_fd);
+		return -1;
+	}
+
+	while (!stopping)
+	{
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0)
+		{
+			if (stopping)
+			{
+				break;
+			}
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(connections_lock);
+			connections.insert(fd);
+		}
+
+		/*one host thread per connection reads requests, runs happen on the pool*/
+		std::thread([this, fd, &connections, &connections_lock, &connections_done]()
+		{
+			handleConnection(fd);
+
+			std::lock_guard<std::mutex> guard(connections_lock);
+			connections.erase(fd);
+			close(fd);
+			connections_done.notify_all();
+		}).detach();
+	}
+
+	/*wake up every connection still reading and wait for it to finish*/
+	std::unique_lock<std::mutex> guard(connections_lock);
+	for (int fd : connections)
+	{
+		shutdown(fd, SHUT_RD);
+	}
+	connections_done.wait(guard, [&]() { return connections.empty(); });
+
+	/*only the socket this server created is removed, path may have been replaced since*/
+	close(listen_fd);
+	if (lstat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)
+		&& existing.st_dev == created.st_dev && existing.st_ino == created.st_ino)
+	{
+		unlink(path);
+	}
+	return 0;
+}
+
+void SimServer::handleConnection(int fd)
+{
+	/*replies waiting to be written, in request order*/
+	struct Connection
+	{
+		std::mutex lock;
+		std::condition_variable changed;
+		std::deque<std::shared_ptr<Reply>> pending;
+		bool closed = false;
+	};
+	auto conn = std::make_shared<Connection>();
+
+	std::thread writer([fd, conn]()
+	{
+		std::unique_lock<std::mutex> guard(conn->lock);
+		while (true)
+		{
+			conn->changed.wait(guard, [&]()
+			{
+				return (!conn->pending.empty() && conn->pending.front()->done) || (conn->closed && conn->pending.empty());
+			});
+			if (conn->pending.empty())
+			{
+				return;
+			}
+
+			std::shared_ptr<Reply> reply = conn->pending.front();
+			conn->pending.pop_front();
+			guard.unlock();
+			sendAll(fd, reply->text + "\n");
+			guard.lock();
+		}
+	});
+
+	std::string buffer;
+	char chunk[SERVER_READ_SIZE];
+	bool open = true;
+
+	while (open)
+	{
+		ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+		if (n <= 0)
+		{
+			break;
+		}
+		buffer.append(chunk, (size_t)n);
+
+		size_t start = 0;
+		size_t newline;
+		while (open && (newline = buffer.find('\n', start)) != std::string::npos)
+		{
+			std::string line = buffer.substr(start, newline - start);
+			start = newline + 1;
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+			if (line.empty())
+			{
+				continue;
+			}
+			if (line == "QUIT")
+			{
+				open = false;
+				break;
+			}
+
+			auto reply = std::make_shared<Reply>();
+			{
+				std::lock_guard<std::mutex> guard(conn->lock);
+				conn->pending.push_back(reply);
+			}
+			handleRequest(line, reply, [conn, reply]()
+			{
+				std::lock_guard<std::mutex> guard(conn->lock);
+				reply->done = true;
+				conn->changed.notify_all();
+			});
+		}
+		buffer.erase(0, start);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(conn->lock);
+		conn->closed = true;
+		conn->changed.notify_all();
+	}
+	writer.join();
+}
+
+void SimServer::handleRequest(const std::string & line, std::shared_ptr<Reply> reply, std::function<void()> notify)
+{
+	std::istringstream in(line);
+	std::string command;
+	long long received = nowMicros();
+
+	requests++;
+	in >> command;
+
+	if (command == "RUN")
+	{
+		std::string id;
+		std::string policy;
+		RunConfig config;
+		std::shared_ptr<const Workload> workload;
+
+		const char * invalid = nullptr;
+
+		/*a run the simulator can not finish is rejected before it takes a worker*/
+		in >> id >> policy;
+		if (policy == "rr")
+		{
+			config.round_robin = SET;
+			if (!(in >> config.time_quantum) || config.time_quantum < MIN_RR_QUANTUM)
+			{
+				invalid = "rr needs a time quantum of at least 2";
+			}
+			else if (!(in >> std::ws).eof()
+				&& (!(in >> config.thread_switch >> config.process_switch) || config.thread_switch < 1 || config.process_switch < 1))
+			{
+				invalid = "switch costs must be at least 1";
+			}
+		}
+		else if (policy != "fcfs")
+		{
+			invalid = "policy must be fcfs or rr";
+		}
+		if (invalid != nullptr)
+		{
+			errors++;
+			reply->text = errorReply(invalid);
+			notify();
+			return;
+		}
+
+		{
+			std::shared_lock<std::shared_mutex> guard(workloads_lock);
+			auto found = workloads.find(id);
+			if (found != workloads.end())
+			{
+				workload = found->second;
+			}
+		}
+		if (!workload)
+		{
+			errors++;
+			reply->text = errorReply("unknown workload " + id);
+			notify();
+			return;
+		}
+
+		/*the switch costs of the workload itself hang the run just the same*/
+		if ((config.thread_switch < 0 && workload->thread_switch < 1) || (config.process_switch < 0 && workload->process_switch < 1))
+		{
+			errors++;
+			reply->text = errorReply("switch costs of workload " + id + " must be at least 1");
+			notify();
+			return;
+		}
+
+		pool.submit([this, workload, id, config, received, reply, notify](CPUSim & cpu)
+		{
+			reply->text = runRequest(cpu, workload, id, config, nowMicros() - received);
+			total_latency_us += nowMicros() - received;
+			notify();
+		});
+		return;
+	}
+
+	if (command == "LOAD")
+	{
+		std::string id;
+		std::string path;
+		long long begin = nowMicros();
+
+		in >> id >> path;
+		if (id.empty() || path.empty() || !loadWorkload(id, path))
+		{
+			errors++;
+			reply->text = errorReply("could not load " + path);
+		}
+		else
+		{
+			std::shared_lock<std::shared_mutex> guard(workloads_lock);
+			char text[128];
+			snprintf(text, sizeof(text), ",\"threads\":%d,\"load_us\":%lld}", workloads.at(id)->getNumberOfThreads(), nowMicros() - begin);
+			reply->text = "{\"ok\":true,\"id\":" + jsonString(id) + text;
+		}
+	}
+	else if (command == "UNLOAD")
+	{
+		std::string id;
+		in >> id;
+
+		std::unique_lock<std::shared_mutex> guard(workloads_lock);
+		if (workloads.erase(id) == 0)
+		{
+			errors++;
+			reply->text = errorReply("unknown workload " + id);
+		}
+		else
+		{
+			reply->text = "{\"ok\":true,\"id\":" + jsonString(id) + "}";
+		}
+	}
+	else if (command == "STATS")
+	{
+		reply->text = statsReply();
+	}
+	else if (command == "SHUTDOWN")
+	{
+		stopping = true;
+		shutdown(listen_fd, SHUT_RDWR);
+		reply->text = "{\"ok\":true}";
+	}
+	else
+	{
+		errors++;
+		reply->text = errorReply("unknown command " + command);
+	}
+
+	total_latency_us += nowMicros() - received;
+	notify();
+}
+
+std::string SimServer::runRequest(CPUSim & cpu, std::shared_ptr<const Workload> workload, const std::string & id,
+	const RunConfig & config, long long queued_us)
+{
+	long long begin = nowMicros();
+	char text[512];
+
+	cpu.configure(config);
+	cpu.load(*workload);
+	SimResults results = cpu.run();
+
+	long long run_us = nowMicros() - begin;
+	runs++;
+	total_run_us += run_us;
+	simulated_ticks += results.total_time;
+
+	snprintf(text, sizeof(text),
+		",\"policy\":\"%s\",\"quantum\":%d,\"total_time\":%d,\"average_turnaround\":%.1f,"
+		"\"cpu_utilization\":%.1f,\"threads\":%d,\"queue_us\":%lld,\"run_us\":%lld}",
+		config.round_robin == SET ? "rr" : "fcfs", results.time_quantum, results.total_time, results.average_turnaround,
+		results.cpu_utilization, (int)results.threads.size(), queued_us, run_us);
+
+	return "{\"ok\":true,\"workload\":" + jsonString(id) + text;
+}
+
+std::string SimServer::statsReply()
+{
+	double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	long long done = runs;
+	size_t resident = 0;
+	char text[512];
+
+	{
+		std::shared_lock<std::shared_mutex> guard(workloads_lock);
+		resident = workloads.size();
+	}
+
+	snprintf(text, sizeof(text),
+		"{\"ok\":true,\"uptime_s\":%.3f,\"workloads\":%zu,\"workers\":%d,\"requests\":%lld,\"runs\":%lld,\"errors\":%lld,"
+		"\"runs_per_s\":%.1f,\"avg_run_us\":%.1f,\"avg_latency_us\":%.1f,\"ticks_per_s\":%.0f}",
+		uptime, resident, pool.getNumberOfWorkers(), (long long)requests, done, (long long)errors,
+		uptime > 0 ? done / uptime : 0.0, done > 0 ? (double)total_run_us / done : 0.0,
+		requests > 0 ? (double)total_latency_us / requests : 0.0,
+		total_run_us > 0 ? simulated_ticks * 1e6 / total_run_us : 0.0);
+
+	return text;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CPUSim.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define SERVER_BACKLOG 64
+#define SERVER_READ_SIZE 4096
+
+/*fixed pool of host threads, each with its own CPUSim that is reused for every run it does*/
+class RunPool
+{
+public:
+	RunPool(int num_workers);
+	~RunPool();
+
+	/*queues a job, it is handed the CPUSim of the worker that picks it up*/
+	void submit(std::function<void(CPUSim &)> job);
+
+	int getNumberOfWorkers()
+	{
+		return (int)workers.size();
+	}
+
+private:
+	void work();
+
+	std::vector<std::thread> workers;
+	std::queue<std::function<void(CPUSim &)>> jobs;
+	std::mutex lock;
+	std::condition_variable ready;
+	bool stopping;
+};
+
+/*long lived simulator serving requests over a unix domain socket.
+Workloads are parsed once and stay resident under an id, runs against them are done
+concurrently on a RunPool. Requests are single text lines, every reply is one line of JSON:
+
+	LOAD id path                        parse a workload file and keep it as id
+	UNLOAD id                           drop workload id
+	RUN id fcfs                         simulate workload id first come first served
+	RUN id rr quantum [thread_switch process_switch]
+	                                    or round robin, quantum at least 2, switch costs at least 1
+	STATS                               request counts, latencies and throughput
+	QUIT                                close this connection
+	SHUTDOWN                            stop the server
+
+Requests on one connection may be pipelined, replies come back in request order*/
+class SimServer
+{
+public:
+	SimServer(int num_workers);
+
+	/*loads a workload file before serving, returns false if it can not be parsed*/
+	bool loadWorkload(const std::string & id, const std::string & path);
+
+	/*accepts connections on socket path until SHUTDOWN, returns -1 if it can not listen and
+	-2 if something other than a socket is in the way at path*/
+	int serve(const char * path);
+
+private:
+	/*reply to one request, filled in by whichever thread handles it*/
+	struct Reply
+	{
+		std::string text;
+		bool done = false;
+	};
+
+	void handleConnection(int fd);
+	void handleRequest(const std::string & line, std::shared_ptr<Reply> reply, std::function<void()> notify);
+	std::string runRequest(CPUSim & cpu, std::shared_ptr<const Workload> workload, const std::string & id,
+		const RunConfig & config, long long queued_us);
+	std::string statsReply();
+
+	RunPool pool;
+	std::map<std::string, std::shared_ptr<const Workload>> workloads;   /*resident parsed workloads*/
+	std::shared_mutex workloads_lock;
+	std::atomic<bool> stopping;
+	int listen_fd;
+
+	/*metrics, all times in microseconds*/
+	std::chrono::steady_clock::time_point started;
+	std::atomic<long long> requests;
+	std::atomic<long long> runs;
+	std::atomic<long long> errors;
+	std::atomic<long long> total_run_us;
+	std::atomic<long long> total_latency_us;
+	std::atomic<long long> simulated_ticks;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Burst.h"
+#include "Workload.h"
 #include <list>
 #include <stdio.h>
 #define DEFAULT_EXIT_VALUE -1
@@ -14,23 +15,68 @@ public:
 	Thread(int process_num, int thread_num, int arrival_t, int cpu_bursts)
 	{
 		process_number = process_num;
+		process_index = process_num; /*no process table, the number serves as the index*/
 		thread_number = thread_num;
 
 		cpu_time = 0;
 		cpu_thread_total = 0;
 		io_thread_total = 0;
 		io_time_remaining = 0;
+		io_device = 0;
 
 		arrival_time = arrival_t;
 		start_time = -1;
 		exit_time = DEFAULT_EXIT_VALUE;
 
 		bursts = cpu_bursts;
+		index = -1;
+		ready_time = arrival_t;
+		migrated = false;
 	}
 
-	void addBurst(int cpu_time, int io_time)
+	/*creates a runnable thread from a workload description*/
+	Thread(const ThreadSpec & spec)
 	{
-		Burst burst(cpu_time, io_time);
+		process_number = spec.process_number;
+		process_index = spec.process_index;
+		thread_number = spec.thread_number;
+
+		cpu_time = 0;
+		cpu_thread_total = 0;
+		io_thread_total = 0;
+		io_time_remaining = 0;
+		io_device = 0;
+
+		arrival_time = spec.arrival_time;
+		start_time = -1;
+		exit_time = DEFAULT_EXIT_VALUE;
+
+		bursts = (int)spec.bursts.size() + spec.generator.getCount() + spec.encoded.getCount();
+		burst_queue.assign(spec.bursts.begin(), spec.bursts.end());
+		generator = spec.generator;
+		encoded = spec.encoded;
+		index = -1;
+		ready_time = arrival_time;
+		migrated = false;
+
+		/*the coroutine only gets a reference to context, which lives as long as the thread*/
+		context.clock = arrival_time;
+		context.last_wait = 0;
+		context.bursts_done = 0;
+		context.process_number = process_number;
+		context.thread_number = thread_number;
+		if (spec.program != nullptr)
+		{
+			program = spec.program(context, spec.program_arg);
+		}
+	}
+
+	Thread(const Thread &) = delete;
+	Thread & operator=(const Thread &) = delete;
+
+	void addBurst(int cpu_time, int io_time, int device = 0)
+	{
+		Burst burst(cpu_time, io_time, device);
 		burst_queue.push_back(burst);
 	}
 
@@ -49,6 +95,12 @@ public:
 		return io_time_remaining;
 	}
 
+	/*io device of the current burst*/
+	int getIODevice()
+	{
+		return io_device;
+	}
+
 	int getThreadNumber()
 	{
 		return thread_number;
@@ -59,6 +111,22 @@ public:
 		return process_number;
 	}
 
+	/*dense index of the process, see ProcessTable*/
+	int getProcessIndex()
+	{
+		return process_index;
+	}
+
+	int getIndex()
+	{
+		return index;
+	}
+
+	void setIndex(int i)
+	{
+		index = i;
+	}
+
 	int getStartTime()
 	{
 		return start_time;
@@ -98,16 +166,67 @@ public:
 		exit_time = t;
 	}
 
-	void decrement()
+	/*true until the first dispatch of a thread whose process is cached by another cpu*/
+	bool isMigrated()
+	{
+		return migrated;
+	}
+
+	void setMigrated(bool m)
+	{
+		migrated = m;
+	}
+
+	/*records the time the thread entered the ready queue*/
+	void setReadyTime(int t)
 	{
-		io_time_remaining--;
+		ready_time = t;
+	}
+
+	/*records that the thread starts running at time t, called right before setTimings*/
+	void setDispatchTime(int t)
+	{
+		context.clock = t;
+		context.last_wait = t - ready_time;
 	}
 
 	void setTimings()
 	{
+		/*bursts still to be drawn from the generator run before any burst queued by a preemption*/
+		if (generator.hasNext())
+		{
+			Burst burst = generator.next();
+			cpu_time = burst.get_cpu_time();
+			io_time_remaining = burst.get_io_time();
+			io_device = burst.get_device();
+			return;
+		}
+
+		/*same for bursts still to be decoded from the compressed store*/
+		if (encoded.hasNext())
+		{
+			Burst burst = encoded.next();
+			cpu_time = burst.get_cpu_time();
+			io_time_remaining = burst.get_io_time();
+			io_device = burst.get_device();
+			return;
+		}
+
+		/*and for bursts a coroutine program has not yielded yet*/
+		if (program.isActive())
+		{
+			Burst burst = program.next();
+			context.bursts_done++;
+			cpu_time = burst.get_cpu_time();
+			io_time_remaining = burst.get_io_time();
+			io_device = burst.get_device();
+			return;
+		}
+
 		Burst burst = burst_queue.front();
 		cpu_time = burst.get_cpu_time();
 		io_time_remaining = burst.get_io_time();
+		io_device = burst.get_device();
 		burst_queue.pop_front();
 	}
 
@@ -141,14 +260,23 @@ public:
 
 private:
 	int process_number;         /*represents the process to which this thread belongs*/
+	int process_index;          /*dense index of the process in the process table of the workload*/
 	int thread_number;          /*thread number w.r.t. process*/
 	int arrival_time;           /*time it arrives in CPUSim */
 	int start_time;             /*time when it begins execution */
-	int io_time_remaining;      /*for decrementing in IO queue*/
+	int io_time_remaining;      /*length of the current io burst*/
+	int io_device;              /*device the current io burst is served by*/
 	int cpu_time;               /*length of the current cpu burst*/
 	int io_thread_total;        /*total io time done by thread*/
 	int cpu_thread_total;       /*total cpu time done by thread*/
 	int exit_time;              /*time it exits the CPUSim*/
 	int bursts;                 /*number of cpu-io burst pairs*/
+	int index;                  /*position in the thread table of the CPUSim, -1 until it is added*/
+	bool migrated;              /*see isMigrated*/
 	std::list<Burst> burst_queue;   /*execution stack of the thread*/
+	BurstGenerator generator;       /*draws bursts on demand for threads described by a distribution*/
+	BurstCursor encoded;            /*decodes bursts on demand for threads with compressed bursts*/
+	int ready_time;                 /*time the thread last entered the ready queue*/
+	ProgramContext context;         /*what a coroutine program sees of the thread*/
+	BurstProgram program;           /*yields bursts on demand for programmable threads*/
 };
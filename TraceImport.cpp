@@ -0,0 +1,510 @@
+#include "TraceImport.h"
+#include <climits>
+#include <string.h>
+
+#define TRACE_READ_CHUNK (1 << 20)  /*bytes read from the trace per chunk*/
+
+/*finds str in [s, e), returns nullptr if it is not there*/
+static const char * findStr(const char * s, const char * e, const char * str)
+{
+	size_t n = strlen(str);
+
+	for (; s + n <= e; s++)
+	{
+		if (*s == *str && memcmp(s, str, n) == 0)
+		{
+			return s;
+		}
+	}
+	return nullptr;
+}
+
+/*parses the digits starting at s, returns -1 if there are none*/
+static int parseInt(const char * s, const char * e)
+{
+	int value = 0;
+
+	if (s >= e || *s < '0' || *s > '9')
+	{
+		return -1;
+	}
+	for (; s < e && *s >= '0' && *s <= '9'; s++)
+	{
+		value = value * 10 + (*s - '0');
+	}
+	return value;
+}
+
+/*value of a key=value field such as prev_pid=, -1 if the field is missing*/
+static int fieldInt(const char * s, const char * e, const char * key)
+{
+	const char * p = findStr(s, e, key);
+
+	if (p == nullptr)
+	{
+		return -1;
+	}
+	return parseInt(p + strlen(key), e);
+}
+
+/*pid of a perf style "comm:pid [prio]" task, searched for in [s, e)*/
+static int compactPid(const char * s, const char * e)
+{
+	const char * bracket = findStr(s, e, " [");
+	const char * colon = nullptr;
+
+	if (bracket == nullptr)
+	{
+		bracket = e;
+	}
+	for (const char * p = s; p < bracket; p++)
+	{
+		if (*p == ':')
+		{
+			colon = p;
+		}
+	}
+	if (colon == nullptr)
+	{
+		return -1;
+	}
+	return parseInt(colon + 1, bracket);
+}
+
+/*parses the "seconds.fraction:" timestamp that ends right before position end, in nanoseconds*/
+static long long parseTimestamp(const char * line, const char * end)
+{
+	const char * p = end;
+	long long sec = 0;
+	long long frac = 0;
+	int frac_digits = 0;
+
+	/*walk back over the timestamp*/
+	while (p > line && ((p[-1] >= '0' && p[-1] <= '9') || p[-1] == '.'))
+	{
+		p--;
+	}
+	if (p == end)
+	{
+		return -1;
+	}
+	for (; p < end && *p != '.'; p++)
+	{
+		sec = sec * 10 + (*p - '0');
+	}
+	for (p++; p < end && frac_digits < 9; p++, frac_digits++)
+	{
+		frac = frac * 10 + (*p - '0');
+	}
+	for (; frac_digits < 9; frac_digits++)
+	{
+		frac *= 10;
+	}
+	return sec * 1000000000LL + frac;
+}
+
+TraceImporter::TraceImporter(Workload & w, const TraceImportOptions & opts) : workload(w), options(opts)
+{
+	first_ts = -1;
+	last_ts = 0;
+	lines_parsed = 0;
+	events_used = 0;
+	overflow = false;
+
+	if (options.time_unit_ns < 1)
+	{
+		options.time_unit_ns = 1;
+	}
+}
+
+void TraceImporter::feedLine(const char * line, size_t len)
+{
+	const char * end = line + len;
+	const char * event = nullptr;
+	const char * body = nullptr;
+	const char * ts_end = nullptr;
+	long long ts = 0;
+	int kind = 0;
+
+	lines_parsed++;
+
+	/*find which scheduler event (if any) is on the line*/
+	if ((event = findStr(line, end, "sched_switch:")) != nullptr)
+	{
+		kind = 1;
+		body = event + strlen("sched_switch:");
+	}
+	else if ((event = findStr(line, end, "sched_wakeup_new:")) != nullptr)
+	{
+		kind = 2;
+		body = event + strlen("sched_wakeup_new:");
+	}
+	else if ((event = findStr(line, end, "sched_wakeup:")) != nullptr)
+	{
+		kind = 2;
+		body = event + strlen("sched_wakeup:");
+	}
+	else if ((event = findStr(line, end, "sched_process_exit:")) != nullptr)
+	{
+		kind = 3;
+		body = event + strlen("sched_process_exit:");
+	}
+	else
+	{
+		return;
+	}
+
+	/*perf prefixes the event name with its subsystem, "sched:sched_switch:"*/
+	ts_end = event;
+	if (ts_end - line >= 6 && memcmp(ts_end - 6, "sched:", 6) == 0)
+	{
+		ts_end -= 6;
+	}
+	while (ts_end > line && ts_end[-1] == ' ')
+	{
+		ts_end--;
+	}
+	if (ts_end == line || ts_end[-1] != ':')
+	{
+		return;
+	}
+	ts = parseTimestamp(line, ts_end - 1);
+	if (ts < 0)
+	{
+		return;
+	}
+
+	if (first_ts == -1)
+	{
+		first_ts = ts;
+	}
+	if (ts > last_ts)
+	{
+		last_ts = ts;
+	}
+
+	/*ftrace with the record-tgid option prints "comm-pid (tgid) [cpu]" before the timestamp*/
+	int header_pid = 0;
+	int header_tgid = 0;
+	const char * open = findStr(line, event, "(");
+	const char * close = open != nullptr ? findStr(open, event, ")") : nullptr;
+	if (close != nullptr)
+	{
+		const char * p = open + 1;
+		while (p < close && *p == ' ')
+		{
+			p++;
+		}
+		const char * q = open;
+		while (q > line && q[-1] == ' ')
+		{
+			q--;
+		}
+		const char * pid_start = q;
+		while (pid_start > line && pid_start[-1] >= '0' && pid_start[-1] <= '9')
+		{
+			pid_start--;
+		}
+		header_tgid = parseInt(p, close);
+		header_pid = parseInt(pid_start, q);
+	}
+
+	/*the task on the line may exit with this event or only be seen from it on*/
+	setTgid(header_pid, header_tgid);
+
+	if (kind == 1)
+	{
+		const char * arrow = findStr(body, end, "==>");
+		int prev_pid = fieldInt(body, end, "prev_pid=");
+		int next_pid = fieldInt(body, end, "next_pid=");
+		char prev_state = 'R';
+
+		if (arrow == nullptr)
+		{
+			return;
+		}
+
+		if (prev_pid >= 0)
+		{
+			const char * s = findStr(body, end, "prev_state=");
+			if (s != nullptr)
+			{
+				prev_state = s[strlen("prev_state=")];
+			}
+		}
+		else
+		{
+			/*perf compact form "prev_comm:prev_pid [prio] S ==> next_comm:next_pid [prio]"*/
+			const char * close_bracket = findStr(body, arrow, "] ");
+			prev_pid = compactPid(body, arrow);
+			next_pid = compactPid(arrow + 3, end);
+			if (close_bracket != nullptr)
+			{
+				prev_state = close_bracket[2];
+			}
+		}
+
+		if (prev_pid > 0)
+		{
+			switchOut(prev_pid, prev_state, ts);
+		}
+		if (next_pid > 0)
+		{
+			switchIn(next_pid, ts);
+		}
+	}
+	else
+	{
+		int pid = fieldInt(body, end, "pid=");
+
+		if (pid < 0)
+		{
+			pid = compactPid(body, end);
+		}
+		if (pid <= 0)
+		{
+			return;
+		}
+
+		if (kind == 2)
+		{
+			wakeup(pid, ts);
+		}
+		else
+		{
+			exitTask(pid, ts);
+		}
+	}
+
+	setTgid(header_pid, header_tgid);
+	events_used++;
+}
+
+void TraceImporter::finish()
+{
+	std::unordered_map<int, int> process_number;   /*tgid -> dense process number*/
+	std::vector<int> threads_in_process;
+
+	/*threads still alive at the end of the trace exit there*/
+	for (auto & entry : live)
+	{
+		LiveTask & t = entry.second;
+		if (t.state == TASK_RUNNING)
+		{
+			t.cpu += last_ts - t.since;
+		}
+		emit(t);
+	}
+	live.clear();
+
+	/*processes and threads are numbered densely from 1 in order of first appearance,
+	emit() left the thread group in process_number*/
+	workload.processes.clear();
+	for (int i = 0; i < (int)workload.threads.size(); i++)
+	{
+		int group = workload.threads[i].process_number;
+		auto found = process_number.find(group);
+
+		if (found == process_number.end())
+		{
+			found = process_number.emplace(group, (int)threads_in_process.size() + 1).first;
+			threads_in_process.push_back(0);
+		}
+		workload.threads[i].process_number = found->second;
+		workload.threads[i].process_index = workload.processes.add(found->second);
+		workload.threads[i].thread_number = ++threads_in_process[found->second - 1];
+	}
+
+	workload.num_of_processes = (int)threads_in_process.size();
+	workload.setSwitchCosts(options.thread_switch, options.process_switch);
+}
+
+TraceImporter::LiveTask & TraceImporter::task(int pid, long long ts)
+{
+	auto found = live.find(pid);
+
+	if (found != live.end())
+	{
+		return found->second;
+	}
+
+	/*first time this task is seen, it arrives now*/
+	LiveTask t;
+	t.index = workload.addThread(0, 0, toUnits(ts - first_ts));
+	t.pid = pid;
+	t.tgid = 0;
+	t.state = TASK_RUNNABLE;
+	t.since = ts;
+	t.cpu = 0;
+
+	return live.emplace(pid, t).first->second;
+}
+
+void TraceImporter::switchOut(int pid, char prev_state, long long ts)
+{
+	bool preempted = (prev_state == 'R');
+
+	/*a task switched out dead has already been closed by its exit event*/
+	if ((prev_state == 'X' || prev_state == 'Z') && live.find(pid) == live.end())
+	{
+		return;
+	}
+
+	LiveTask & t = task(pid, ts);
+	if (t.state == TASK_RUNNING)
+	{
+		t.cpu += ts - t.since;
+	}
+	t.state = preempted ? TASK_RUNNABLE : TASK_BLOCKED;
+	t.since = ts;
+}
+
+void TraceImporter::switchIn(int pid, long long ts)
+{
+	LiveTask & t = task(pid, ts);
+
+	/*the wakeup was not traced, the task was blocked up to now*/
+	if (t.state == TASK_BLOCKED)
+	{
+		wakeup(pid, ts);
+	}
+	t.state = TASK_RUNNING;
+	t.since = ts;
+}
+
+void TraceImporter::wakeup(int pid, long long ts)
+{
+	LiveTask & t = task(pid, ts);
+
+	/*the time spent blocked becomes the io burst after the cpu burst built so far*/
+	if (t.state == TASK_BLOCKED)
+	{
+		addBurst(t, toUnits(ts - t.since));
+		t.state = TASK_RUNNABLE;
+		t.since = ts;
+	}
+}
+
+void TraceImporter::exitTask(int pid, long long ts)
+{
+	auto found = live.find(pid);
+
+	if (found == live.end())
+	{
+		return;
+	}
+
+	LiveTask & t = found->second;
+	if (t.state == TASK_RUNNING)
+	{
+		t.cpu += ts - t.since;
+	}
+	emit(t);
+	live.erase(found);
+}
+
+void TraceImporter::setTgid(int pid, int tgid)
+{
+	if (pid <= 0 || tgid <= 0)
+	{
+		return;
+	}
+
+	auto found = live.find(pid);
+	if (found != live.end())
+	{
+		found->second.tgid = tgid;
+	}
+}
+
+/*the task has exited, its last burst and its thread group go into the workload*/
+void TraceImporter::emit(LiveTask & t)
+{
+	addBurst(t, -1);
+	if (workload.compress_bursts)
+	{
+		workload.compressThreadPart(t.index, t.chain, true);
+	}
+	workload.threads[t.index].process_number = (t.tgid > 0) ? t.tgid : t.pid;
+}
+
+void TraceImporter::addBurst(LiveTask & t, long long io)
+{
+	int cpu = toUnits(t.cpu);
+
+	if (cpu < MIN_CPU_BURST)
+	{
+		cpu = MIN_CPU_BURST;
+	}
+	workload.addBurst(t.index, cpu, (int)io);
+	t.cpu = 0;
+
+	/*a long lived task does not keep all of its bursts uncompressed until it exits*/
+	if (io >= 0 && workload.compress_bursts && workload.threads[t.index].bursts.size() >= TRACE_SEGMENT_BURSTS)
+	{
+		workload.compressThreadPart(t.index, t.chain, false);
+	}
+}
+
+int TraceImporter::toUnits(long long ns)
+{
+	long long units = ns / options.time_unit_ns;
+
+	/*lines a little out of order, as per cpu buffers of a trace can be, count as no time*/
+	if (units < 0)
+	{
+		return 0;
+	}
+	if (units > INT_MAX)
+	{
+		overflow = true;
+		return INT_MAX;
+	}
+	return (int)units;
+}
+
+/*reads a whole trace from the stream in fixed size chunks and fills the workload*/
+int importTrace(std::istream & in, Workload & workload, const TraceImportOptions & options)
+{
+	std::vector<char> buffer(TRACE_READ_CHUNK);
+	size_t used = 0;
+	TraceImporter importer(workload, options);
+
+	workload.clear();
+	workload.compress_bursts = options.compress_bursts;
+
+	while (in)
+	{
+		/*a single line longer than the buffer makes it grow*/
+		if (used == buffer.size())
+		{
+			buffer.resize(buffer.size() * 2);
+		}
+
+		in.read(buffer.data() + used, buffer.size() - used);
+		size_t filled = used + (size_t)in.gcount();
+		size_t start = 0;
+
+		for (size_t i = used; i < filled; i++)
+		{
+			if (buffer[i] == '\n')
+			{
+				importer.feedLine(buffer.data() + start, i - start);
+				start = i + 1;
+			}
+		}
+
+		/*keep the partial line at the end for the next chunk*/
+		used = filled - start;
+		memmove(buffer.data(), buffer.data() + start, used);
+	}
+
+	if (used > 0)
+	{
+		importer.feedLine(buffer.data(), used);
+	}
+
+	importer.finish();
+
+	return importer.hasOverflowed() ? -1 : 1;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Workload.h"
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define DEFAULT_TRACE_UNIT_NS 1000  /*one simulated time unit per microsecond of trace*/
+#define TRACE_SEGMENT_BURSTS 256    /*bursts of a live task compressed at a time*/
+
+/*options for turning a linux scheduler trace into a workload*/
+struct TraceImportOptions
+{
+	TraceImportOptions()
+	{
+		time_unit_ns = DEFAULT_TRACE_UNIT_NS;
+		thread_switch = 1;
+		process_switch = 2;
+		compress_bursts = false;
+	}
+
+	long long time_unit_ns;     /*nanoseconds of trace time per simulated time unit*/
+	int thread_switch;          /*switch costs given to the workload, traces do not record them*/
+	int process_switch;
+	bool compress_bursts;       /*compress the bursts of every thread once it exits*/
+};
+
+/*streaming importer for `perf sched script` and ftrace text dumps, understands the
+sched_switch, sched_wakeup, sched_wakeup_new and sched_process_exit events.
+A linux task (pid) becomes a Thread, its thread group (tgid, when the trace records it)
+becomes the process. Time spent running is a cpu burst, time between being switched out
+in a blocked state and being woken up is the io burst that follows it.
+Only threads that are currently alive are kept in the importer, the bursts and the thread
+group go straight into the workload, so memory does not grow with the length of the trace itself.
+When the workload compresses, the bursts of a live task are compressed TRACE_SEGMENT_BURSTS at a
+time rather than when it exits. Trace lines out of time order never give negative times*/
+class TraceImporter
+{
+public:
+	TraceImporter(Workload & w, const TraceImportOptions & opts);
+
+	/*parses one line of the trace, lines that are not scheduler events are ignored*/
+	void feedLine(const char * line, size_t len);
+
+	/*closes every thread still alive and numbers processes/threads in the workload*/
+	void finish();
+
+	long long getLinesParsed()
+	{
+		return lines_parsed;
+	}
+
+	long long getEventsUsed()
+	{
+		return events_used;
+	}
+
+	/*true if some time did not fit into an int at the chosen time unit*/
+	bool hasOverflowed()
+	{
+		return overflow;
+	}
+
+private:
+	/*what a traced task is doing at the moment*/
+	typedef enum TaskState {
+		TASK_RUNNABLE = 0,
+		TASK_RUNNING = 1,
+		TASK_BLOCKED = 2
+	} TaskState;
+
+	struct LiveTask
+	{
+		int index;              /*thread index in the workload*/
+		int pid;
+		int tgid;               /*thread group, 0 until the trace records it*/
+		TaskState state;
+		long long since;        /*trace time the current state was entered*/
+		long long cpu;          /*cpu time of the burst being built*/
+		BurstChain chain;       /*bursts compressed so far, when the workload compresses*/
+	};
+
+	LiveTask & task(int pid, long long ts);
+	void switchOut(int pid, char prev_state, long long ts);
+	void switchIn(int pid, long long ts);
+	void wakeup(int pid, long long ts);
+	void exitTask(int pid, long long ts);
+	void setTgid(int pid, int tgid);
+	void emit(LiveTask & t);
+	void addBurst(LiveTask & t, long long io);
+	int toUnits(long long ns);
+
+	Workload & workload;
+	TraceImportOptions options;
+	std::unordered_map<int, LiveTask> live;     /*pid -> task, only tasks that have not exited*/
+	long long first_ts;         /*trace time that becomes time 0*/
+	long long last_ts;
+	long long lines_parsed;
+	long long events_used;
+	bool overflow;
+};
+
+/*reads a whole trace from the stream in fixed size chunks and fills the workload*/
+int importTrace(std::istream & in, Workload & workload, const TraceImportOptions & options);
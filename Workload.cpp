@@ -0,0 +1,131 @@
+#include "Workload.h"
+#include <ctype.h>
+
+/*parses a complete workload in the text format from a stream*/
+int parseWorkload(std::istream & in, Workload & workload)
+{
+	workload.clear();
+
+	parseCPUInfo(in, workload); /*parses the first line of the file bc it does not show up in the file pattern again*/
+
+	parseProcesses(in, workload); /*parse all processes in the file, based off of info from parseCPUInfo*/
+
+	return 1;
+}
+
+/*parses the first line of the file*/
+int parseCPUInfo(std::istream & in, Workload & workload)
+{
+	in >> workload.num_of_processes >> workload.thread_switch >> workload.process_switch;
+
+	return 1;
+}
+
+/*responsible for parsing all processes and their threads in file*/
+int parseProcesses(std::istream & in, Workload & workload)
+{
+	int process_num = 0;
+	int num_of_threads = 0;
+
+	/*for the number of processes in the file...*/
+	for (int i = 0; i < workload.num_of_processes; i++)
+	{
+		/*scan in process number, and num of threads in said process*/
+		in.ignore(200, '\n');
+		in >> process_num >> num_of_threads;
+		/*a process counts even if it declares no threads*/
+		workload.processes.add(process_num);
+		/*parse threads based off number of threads in process*/
+		parseThreads(in, workload, process_num, num_of_threads);
+	}
+
+	return 1;
+}
+
+/*responsible for parsing all threads in a given process*/
+int parseThreads(std::istream & in, Workload & workload, int process_num, int num_of_threads)
+{
+	/*for all threads in a process...*/
+	for (int i = 0; i < num_of_threads; i++)
+	{
+		/*parse a thread*/
+		parseThread(in, workload, process_num);
+	}
+
+	return 1;
+}
+
+/*parses one thread from file*/
+int parseThread(std::istream & in, Workload & workload, int process_num)
+{
+	int thread_number = 0;
+	int arrival_time = -1;
+	int num_of_bursts = 0;
+	int thread_index = 0;
+
+	/*scan in thread num wrt to process, its arrival time, and number of cpu burts*/
+	in.ignore(200, '\n');
+	in >> thread_number >> arrival_time >> num_of_bursts;
+
+	/*add a new thread description to the workload with parsed info*/
+	thread_index = workload.addThread(process_num, thread_number, arrival_time);
+
+	/*parse the execution stack of the thread based on 'num_of_bursts'*/
+	parseBursts(in, workload, thread_index, num_of_bursts);
+
+	if (workload.compress_bursts)
+	{
+		workload.compressThread(thread_index);
+	}
+
+	return 1;
+}
+
+/*reads the io device that may follow the io time of a burst on the same line, 0 if there is none*/
+static int parseDevice(std::istream & in)
+{
+	int device = 0;
+
+	while (in.peek() == ' ' || in.peek() == '\t')
+	{
+		in.get();
+	}
+	if (isdigit(in.peek()))
+	{
+		in >> device;
+	}
+	return device;
+}
+
+/*parses the execution stack of one thread*/
+int parseBursts(std::istream & in, Workload & workload, int thread_index, int num_of_bursts)
+{
+	int burst_num = 0;
+	int cpu_time = 0;
+	int io_time = 0;
+	int device = 0;
+
+	if (thread_index < 0 || thread_index >= workload.getNumberOfThreads())
+	{
+		return -1;
+	}
+
+	/*for x-1 number of bursts in the stack...*/
+	for (int i = 0; i < (num_of_bursts - 1); i++)
+	{
+		/*scan in info*/
+		in.ignore(200, '\n');
+		in >> burst_num >> cpu_time >> io_time;
+		device = parseDevice(in);
+		/*add info to execution stack of the thread description*/
+		workload.addBurst(thread_index, cpu_time, io_time, device);
+	}
+
+	/*scan in the last burst seperatley, because we expect the last burst to have no io*/
+	in.ignore(200, '\n');
+	in >> burst_num >> cpu_time;
+	/*set last io burst to -1 for signal use later*/
+	workload.addBurst(thread_index, cpu_time, -1);
+
+	return 1;
+}
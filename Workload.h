@@ -0,0 +1,193 @@
+#pragma once
+
+#include "Burst.h"
+#include "BurstGenerator.h"
+#include "BurstProgram.h"
+#include "BurstStore.h"
+#include "ProcessTable.h"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/*describes one thread of a workload before it is loaded into a CPUSim, the last burst
+of a thread has an io time of -1. A thread has either a list of bursts, bursts compressed
+into the BurstStore of its workload, a generator that draws them while the thread runs,
+or a coroutine program that yields them*/
+struct ThreadSpec
+{
+	int process_number;         /*process to which the thread belongs*/
+	int process_index;          /*dense index of the process in the process table of the workload*/
+	int thread_number;          /*thread number w.r.t. process*/
+	int arrival_time;           /*time it arrives in CPUSim*/
+	std::vector<Burst> bursts;  /*cpu-io burst pairs in execution order*/
+	BurstGenerator generator;   /*draws the bursts lazily when bursts is empty*/
+	BurstCursor encoded;        /*compressed bursts, see Workload::compressThread*/
+	ProgramFactory program;     /*if set, creates the coroutine that yields the bursts*/
+	long long program_arg;      /*passed to program*/
+};
+
+/*an in-memory workload, built either from the text format or directly through addThread/addBurst,
+a workload is never modified by a run so one workload can be loaded into any number of CPUSims*/
+class Workload
+{
+public:
+	Workload()
+	{
+		num_of_processes = 0;
+		thread_switch = 0;
+		process_switch = 0;
+		compress_bursts = false;
+	}
+
+	void setSwitchCosts(int thread_sw, int process_sw)
+	{
+		thread_switch = thread_sw;
+		process_switch = process_sw;
+	}
+
+	/*adds a thread with no bursts yet, returns its index for use with addBurst*/
+	int addThread(int process_num, int thread_num, int arrival_t)
+	{
+		ThreadSpec spec;
+		spec.process_number = process_num;
+		spec.process_index = processes.add(process_num);
+		spec.thread_number = thread_num;
+		spec.arrival_time = arrival_t;
+		spec.program = nullptr;
+		spec.program_arg = 0;
+		threads.push_back(spec);
+		return (int)threads.size() - 1;
+	}
+
+	/*adds a thread whose bursts are drawn on demand from a generator, returns its index*/
+	int addGeneratedThread(int process_num, int thread_num, int arrival_t, const BurstGenerator & generator)
+	{
+		int index = addThread(process_num, thread_num, arrival_t);
+		threads[index].generator = generator;
+		return index;
+	}
+
+	/*adds a thread whose bursts are yielded by a coroutine created from program, returns its index*/
+	int addProgramThread(int process_num, int thread_num, int arrival_t, ProgramFactory program, long long arg)
+	{
+		int index = addThread(process_num, thread_num, arrival_t);
+		threads[index].program = program;
+		threads[index].program_arg = arg;
+		return index;
+	}
+
+	/*appends a cpu-io pair to a thread, pass -1 as the io time of the last burst*/
+	void addBurst(int thread_index, int cpu_t, int io_t, int device = 0)
+	{
+		threads[thread_index].bursts.push_back(Burst(cpu_t, io_t, device));
+	}
+
+	/*moves the bursts of a thread into the compressed store, the thread must be complete*/
+	void compressThread(int thread_index)
+	{
+		ThreadSpec & spec = threads[thread_index];
+
+		if (!store)
+		{
+			store = std::make_shared<BurstStore>();
+		}
+		spec.encoded = store->add(spec.bursts);
+		std::vector<Burst>().swap(spec.bursts);
+	}
+
+	/*moves the bursts of a thread gathered so far into the compressed store as the next segment
+	of chain, more bursts may be added to the thread and compressed until complete is set*/
+	void compressThreadPart(int thread_index, BurstChain & chain, bool complete)
+	{
+		ThreadSpec & spec = threads[thread_index];
+
+		if (!store)
+		{
+			store = std::make_shared<BurstStore>();
+		}
+		chain.add(*store, spec.bursts, !complete);
+		spec.encoded = chain.getCursor();
+		spec.bursts.clear();
+		if (complete)
+		{
+			std::vector<Burst>().swap(spec.bursts);
+		}
+	}
+
+	/*moves every thread (and compressed burst) of other to the end of this workload*/
+	void append(Workload & other)
+	{
+		/*processes of other, including any without threads, keep their order*/
+		std::vector<int> remap(other.processes.size());
+		for (int i = 0; i < other.processes.size(); i++)
+		{
+			remap[i] = processes.add(other.processes.getProcessNumber(i));
+		}
+
+		threads.reserve(threads.size() + other.threads.size());
+		for (ThreadSpec & spec : other.threads)
+		{
+			spec.process_index = remap[spec.process_index];
+			threads.push_back(std::move(spec));
+		}
+		other.processes.clear();
+		other.threads.clear();
+
+		if (other.store)
+		{
+			if (!store)
+			{
+				store = std::make_shared<BurstStore>();
+			}
+			store->absorb(*other.store);
+		}
+	}
+
+	int getNumberOfThreads() const
+	{
+		return (int)threads.size();
+	}
+
+	/*bytes used by compressed bursts*/
+	size_t getCompressedBytes() const
+	{
+		return store ? store->getBytes() : 0;
+	}
+
+	void clear()
+	{
+		num_of_processes = 0;
+		thread_switch = 0;
+		process_switch = 0;
+		processes.clear();
+		threads.clear();
+		store = nullptr;
+	}
+
+public:
+	int num_of_processes;       /*number of processes declared by the workload*/
+	int thread_switch;          /*time it takes to switch to different thread in same procees*/
+	int process_switch;         /*time it takes to switch process*/
+	ProcessTable processes;     /*every process declared or given a thread, in order of appearance*/
+	std::vector<ThreadSpec> threads;    /*threads in the order they were parsed/added*/
+	bool compress_bursts;       /*if true, parsers compress each thread as soon as it is complete*/
+	std::shared_ptr<BurstStore> store;  /*compressed bursts, shared by copies of the workload*/
+};
+
+/*parses a complete workload in the text format from a stream*/
+int parseWorkload(std::istream & in, Workload & workload);
+
+/*parses the first line of the file*/
+int parseCPUInfo(std::istream & in, Workload & workload);
+
+/*responsible for parsing all processes and their threads in file*/
+int parseProcesses(std::istream & in, Workload & workload);
+
+/*responsible for parsing all threads in a given process*/
+int parseThreads(std::istream & in, Workload & workload, int process_num, int num_of_threads);
+
+/*parses one thread from file*/
+int parseThread(std::istream & in, Workload & workload, int process_num);
+
+/*parses the execution stack of one thread*/
+int parseBursts(std::istream & in, Workload & workload, int thread_index, int num_of_bursts);
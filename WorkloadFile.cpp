@@ -0,0 +1,392 @@
+#include "WorkloadFile.h"
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+/*reads the text format the way the istream parser does: a record starts by skipping
+the rest of the current line, then reads whitespace separated integers*/
+class TextCursor
+{
+public:
+	TextCursor(const char * begin, const char * e)
+	{
+		p = begin;
+		end = e;
+		failed = false;
+	}
+
+	/*same as in.ignore(PARSE_LINE_SKIP, '\n'), a longer line is left mid-line*/
+	void skipLine()
+	{
+		size_t n = std::min<size_t>(PARSE_LINE_SKIP, end - p);
+		const char * nl = (const char *)memchr(p, '\n', n);
+		p = (nl != nullptr) ? nl + 1 : p + n;
+	}
+
+	void skipSpace()
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\v' || *p == '\f'))
+		{
+			p++;
+		}
+	}
+
+	int readInt()
+	{
+		int sign = 1;
+		int value = 0;
+
+		skipSpace();
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			sign = (*p == '-') ? -1 : 1;
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9')
+		{
+			failed = true;
+			return 0;
+		}
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		return sign * value;
+	}
+
+	/*reads an integer that may follow on the same line, dflt if there is none*/
+	int readOptionalInt(int dflt)
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+		{
+			p++;
+		}
+		return (p < end && *p >= '0' && *p <= '9') ? readInt() : dflt;
+	}
+
+	const char * p;
+	const char * end;
+	bool failed;
+};
+
+/*parses the process blocks in [c.p, c.end) into fragment, same steps as parseProcesses*/
+static void parseBlocks(TextCursor & c, int num_of_blocks, Workload & fragment)
+{
+	for (int i = 0; i < num_of_blocks && !c.failed; i++)
+	{
+		c.skipLine();
+		int process_num = c.readInt();
+		int num_of_threads = c.readInt();
+		fragment.processes.add(process_num);
+
+		for (int t = 0; t < num_of_threads && !c.failed; t++)
+		{
+			c.skipLine();
+			int thread_number = c.readInt();
+			int arrival_time = c.readInt();
+			int num_of_bursts = c.readInt();
+			int thread_index = fragment.addThread(process_num, thread_number, arrival_time);
+
+			for (int b = 0; b < num_of_bursts - 1; b++)
+			{
+				c.skipLine();
+				c.readInt();
+				int cpu_time = c.readInt();
+				int io_time = c.readInt();
+				int device = c.readOptionalInt(0);
+				fragment.addBurst(thread_index, cpu_time, io_time, device);
+			}
+
+			/*the last burst has no io*/
+			c.skipLine();
+			c.readInt();
+			fragment.addBurst(thread_index, c.readInt(), -1);
+
+			if (fragment.compress_bursts)
+			{
+				fragment.compressThread(thread_index);
+			}
+		}
+	}
+}
+
+/*start of the record the next skipLine() leads to, without moving c*/
+static const char * peekRecord(TextCursor c)
+{
+	c.skipLine();
+	c.skipSpace();
+	return c.p;
+}
+
+/*reads up to max integers from the start of the line at p, stops at anything else.
+Returns how many were read*/
+static int readLineInts(const char * p, const char * end, int * values, int max)
+{
+	int n = 0;
+
+	while (n < max && p < end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+		{
+			p++;
+		}
+		const char * digits = (p < end && (*p == '-' || *p == '+')) ? p + 1 : p;
+		if (digits >= end || *digits < '0' || *digits > '9')
+		{
+			break;
+		}
+		values[n] = 0;
+		for (p = digits; p < end && *p >= '0' && *p <= '9'; p++)
+		{
+			values[n] = values[n] * 10 + (*p - '0');
+		}
+		n++;
+	}
+	return n;
+}
+
+/*first non blank character after the line holding p*/
+static const char * nextRecord(const char * p, const char * end)
+{
+	const char * nl = (const char *)memchr(p, '\n', end - p);
+	TextCursor c((nl != nullptr) ? nl + 1 : end, end);
+	c.skipSpace();
+	return c.p;
+}
+
+/*true if the line at p starts a well formed process block: "process threads", then per
+thread "thread arrival bursts", bursts - 1 lines of 3 or 4 numbers and a last line of 2,
+followed by the next process line or the end of the file*/
+static bool isProcessBlock(const char * p, const char * end)
+{
+	int values[4];
+
+	if (readLineInts(p, end, values, 4) != 2 || values[1] < 0)
+	{
+		return false;
+	}
+	for (int t = values[1]; t > 0; t--)
+	{
+		p = nextRecord(p, end);
+		if (readLineInts(p, end, values, 4) != 3 || values[2] < 1)
+		{
+			return false;
+		}
+		for (int b = values[2]; b > 1; b--)
+		{
+			p = nextRecord(p, end);
+			int n = readLineInts(p, end, values, 4);
+			if (n != 3 && n != 4)
+			{
+				return false;
+			}
+		}
+		p = nextRecord(p, end);
+		if (readLineInts(p, end, values, 4) != 2)
+		{
+			return false;
+		}
+	}
+	p = nextRecord(p, end);
+	return p == end || readLineInts(p, end, values, 4) == 2;
+}
+
+/*a run of the file handed to one parse worker*/
+struct ParseChunk
+{
+	const char * begin;     /*first byte, always the start of a line*/
+	const char * first;     /*process line of the first block parsed, where the worker resynced*/
+	const char * stop;      /*cursor after the last block parsed*/
+	int blocks;             /*process blocks parsed*/
+	bool failed;
+	Workload fragment;
+};
+
+/*parses process blocks from c until the next one would start at or after chunk_end,
+at most max_blocks of them*/
+static void parseChunk(TextCursor & c, const char * chunk_end, int max_blocks, ParseChunk & chunk)
+{
+	chunk.blocks = 0;
+	chunk.failed = false;
+	chunk.fragment.clear();
+	while (chunk.blocks < max_blocks)
+	{
+		const char * record = peekRecord(c);
+		if (record >= chunk_end || record == c.end)
+		{
+			break;
+		}
+		parseBlocks(c, 1, chunk.fragment);
+		if (c.failed)
+		{
+			chunk.failed = true;
+			break;
+		}
+		chunk.blocks++;
+	}
+	chunk.stop = c.p;
+}
+
+/*parses the workload text held in [data, data + size)*/
+static int parseWorkloadText(const char * data, size_t size, Workload & workload, int num_workers)
+{
+	TextCursor scan(data, data + size);
+	const char * end = data + size;
+	size_t group_bytes = size / ((size_t)num_workers * 4);
+	bool compress = workload.compress_bursts;
+
+	workload.clear();
+	workload.compress_bursts = compress;
+
+	workload.num_of_processes = scan.readInt();
+	workload.thread_switch = scan.readInt();
+	workload.process_switch = scan.readInt();
+	if (scan.failed)
+	{
+		return -1;
+	}
+
+	if (group_bytes < PARSE_MIN_GROUP_BYTES)
+	{
+		group_bytes = PARSE_MIN_GROUP_BYTES;
+	}
+
+	/*cut the file into chunks at the first line start past every group_bytes*/
+	std::vector<ParseChunk> chunks(1);
+	chunks[0].begin = scan.p;
+	while ((size_t)(end - chunks.back().begin) > group_bytes)
+	{
+		const char * nl = (const char *)memchr(chunks.back().begin + group_bytes, '\n', end - (chunks.back().begin + group_bytes));
+		if (nl == nullptr || nl + 1 == end)
+		{
+			break;
+		}
+		chunks.emplace_back();
+		chunks.back().begin = nl + 1;
+	}
+
+	/*parse the chunks concurrently, each worker but the first resyncs to the first line
+	that looks like a process block and parses up to the next chunk*/
+	std::vector<std::thread> workers;
+	std::atomic<size_t> next(0);
+
+	for (ParseChunk & chunk : chunks)
+	{
+		chunk.fragment.compress_bursts = compress;
+	}
+
+	int pool = (int)std::min<size_t>((size_t)num_workers, chunks.size());
+	for (int w = 0; w < pool; w++)
+	{
+		workers.emplace_back([&]()
+		{
+			size_t k;
+			while ((k = next++) < chunks.size())
+			{
+				ParseChunk & chunk = chunks[k];
+				const char * chunk_end = (k + 1 < chunks.size()) ? chunks[k + 1].begin : end;
+				TextCursor c(chunk.begin, end);
+
+				if (k > 0)
+				{
+					/*start on the newline before the block, where skipLine() expects to be*/
+					c.skipSpace();
+					while (c.p < end && !isProcessBlock(c.p, end))
+					{
+						c.p = nextRecord(c.p, end);
+					}
+					c.p = (const char *)memrchr(chunk.begin - 1, '\n', c.p - chunk.begin + 1);
+				}
+				chunk.first = peekRecord(c);
+				parseChunk(c, chunk_end, workload.num_of_processes, chunk);
+			}
+		});
+	}
+	for (std::thread & worker : workers)
+	{
+		worker.join();
+	}
+
+	/*a chunk is only kept if it resynced to where the one before it stopped, otherwise
+	(a line that only looked like a process block, or one longer than PARSE_LINE_SKIP)
+	it is parsed again from there, so the workload is always the sequential parser's*/
+	int total = 0;
+	size_t used = 0;
+	for (size_t k = 0; k < chunks.size() && total < workload.num_of_processes; k++)
+	{
+		ParseChunk & chunk = chunks[k];
+		int remaining = workload.num_of_processes - total;
+
+		if (k > 0 && (chunk.failed || chunk.blocks > remaining || chunk.first != peekRecord(TextCursor(chunks[k - 1].stop, end))))
+		{
+			const char * chunk_end = (k + 1 < chunks.size()) ? chunks[k + 1].begin : end;
+			TextCursor c(chunks[k - 1].stop, end);
+			parseChunk(c, chunk_end, remaining, chunk);
+		}
+		if (chunk.failed)
+		{
+			return -1;
+		}
+		total += chunk.blocks;
+		used = k + 1;
+	}
+	if (total != workload.num_of_processes)
+	{
+		return -1;
+	}
+
+	/*merging in file order keeps the thread order of the sequential parser*/
+	size_t threads = 0;
+	for (size_t k = 0; k < used; k++)
+	{
+		threads += chunks[k].fragment.threads.size();
+	}
+	workload.threads.reserve(threads);
+	for (size_t k = 0; k < used; k++)
+	{
+		workload.append(chunks[k].fragment);
+	}
+
+	return 1;
+}
+
+int parseWorkloadFile(const char * path, Workload & workload, int num_workers)
+{
+	struct stat info;
+	int fd = open(path, O_RDONLY);
+	int result = -1;
+
+	if (fd < 0)
+	{
+		return -1;
+	}
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	void * data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return -1;
+	}
+	madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+	if (num_workers <= 0)
+	{
+		num_workers = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	result = parseWorkloadText((const char *)data, (size_t)info.st_size, workload, num_workers);
+
+	munmap(data, (size_t)info.st_size);
+	return result;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Workload.h"
+
+#define PARSE_MIN_GROUP_BYTES (1 << 20)   /*smallest run of the file handed to one parse worker*/
+#define PARSE_LINE_SKIP 200               /*characters parseWorkload() skips before each record, see istream::ignore()*/
+
+/*parses a workload in the text format from a file, in parallel.
+The file is memory mapped and cut into chunks at line starts. Each chunk is parsed
+concurrently by num_workers threads (0 for one per hardware thread); the worker of every
+chunk but the first resyncs to the first line that starts a well formed process block
+("process_number number_of_threads" and its threads). Chunks are merged in file order,
+and one that did not resync where the chunk before it stopped is parsed again from there,
+so the workload is the same as the one parseWorkload() builds.
+Returns -1 if the file can not be read or is malformed*/
+int parseWorkloadFile(const char * path, Workload & workload, int num_workers);
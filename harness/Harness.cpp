@@ -0,0 +1,887 @@
+/*golden output regression and performance gate of the simulator.
+
+Build it from the repository root against the simulator library
+	make simharness
+and run it from there
+	harness/simharness [--update] [--golden-only | --perf-only]
+
+Every workload of the corpus is run under every policy by every engine (way of loading and
+running a workload). The verbose transitions and detailed statistics must be identical to
+harness/golden/<workload>-<policy>.txt, engines that have no verbose output are only compared
+on the statistics. Scenarios, runs that do not fit the matrix such as a cluster of several
+nodes, must print exactly harness/golden/<scenario>.txt. Before all that the benchmarks run in
+child processes and fail if their simulated ticks per second drop below, or their peak memory
+grows above, harness/thresholds.txt. Those thresholds are absolute and only hold on the machine
+that recorded them, so 'make check' runs --golden-only and 'make perf' runs --perf-only.
+--update rewrites the golden files from the plain engine and the thresholds from this machine*/
+
+#include "../CPUSim.h"
+#include "../Cluster.h"
+#include "../EventLog.h"
+#include "../ResultsWriter.h"
+#include "../TraceImport.h"
+#include "../WorkloadFile.h"
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#define GOLDEN_DIR "harness/golden/"
+#define TRACE_FILE "harness/sched-trace.txt"
+#define THRESHOLDS_FILE "harness/thresholds.txt"
+#define BENCHMARK_REPEATS 5             /*best of, against scheduling noise*/
+#define THRESHOLD_SPEED_MARGIN 0.7      /*--update allows 70 percent of the measured ticks per second*/
+#define THRESHOLD_MEMORY_MARGIN 1.5     /*and half again the measured peak memory*/
+
+/*a workload of the corpus, read from file or built by build, and run with the changes
+configure makes to the run configuration of every policy*/
+struct CorpusEntry
+{
+	const char * name;
+	const char * file;
+	void (*build)(Workload & workload);
+	void (*configure)(RunConfig & config);
+};
+
+struct Policy
+{
+	const char * name;
+	int time_quantum;           /*NO_QUANTUM_VALUE for FCFS*/
+};
+
+/*a way of loading and running a workload, returns everything it printed*/
+struct Engine
+{
+	const char * name;
+	bool files_only;            /*needs the workload as a file*/
+	bool verbose;               /*prints the verbose transitions*/
+	std::string (*run)(const CorpusEntry & entry, const RunConfig & config);
+};
+
+/*a run outside the policy matrix, compared with harness/golden/<name>.txt*/
+struct Scenario
+{
+	const char * name;
+	std::string (*run)();
+};
+
+struct Benchmark
+{
+	const char * name;
+	void (*build)(Workload & workload);
+	int time_quantum;
+	int cluster_nodes;          /*0 for a single cpu*/
+};
+
+/*measured by a benchmark child*/
+struct Measurement
+{
+	double ticks_per_s;
+	long max_rss_kb;
+};
+
+/*a cpu bound and an io bound process of generated threads with staggered arrivals*/
+static void buildGenerated(Workload & workload)
+{
+	BurstDistribution cpu_bound = { DIST_UNIFORM, 20, 60 };
+	BurstDistribution short_io = { DIST_UNIFORM, 1, 10 };
+	BurstDistribution short_cpu = { DIST_EXPONENTIAL, 6, 2 };
+	BurstDistribution long_io = { DIST_EXPONENTIAL, 80, 20 };
+
+	workload.num_of_processes = 2;
+	workload.setSwitchCosts(3, 7);
+	for (int t = 1; t <= 3; t++)
+	{
+		workload.addGeneratedThread(1, t, t * 15, BurstGenerator(cpu_bound, short_io, 11 * t, 4));
+		workload.addGeneratedThread(2, t, t * 9, BurstGenerator(short_cpu, long_io, 17 * t, 6));
+	}
+}
+
+/*bursts written out in full, with sparse arrivals and gaps where the cpu idles*/
+static void buildBursts(Workload & workload)
+{
+	uint64_t state = 7;
+
+	workload.num_of_processes = 4;
+	workload.setSwitchCosts(2, 5);
+	for (int p = 1; p <= 4; p++)
+	{
+		for (int t = 1; t <= p; t++)
+		{
+			int index = workload.addThread(p, t, (p - 1) * 400 + t * 3);
+			int num_of_bursts = 2 + (int)(state % 4);
+
+			for (int b = 0; b < num_of_bursts; b++)
+			{
+				state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+				int cpu_t = 2 + (int)((state >> 33) % 45);
+				int io_t = 1 + (int)((state >> 17) % 70);
+				workload.addBurst(index, cpu_t, b == num_of_bursts - 1 ? -1 : io_t);
+			}
+		}
+	}
+}
+
+/*shortens its cpu bursts once it has waited long for the cpu*/
+static BurstProgram adaptive(ProgramContext & ctx, long long arg)
+{
+	for (int i = 0; i < arg - 1; i++)
+	{
+		co_yield Burst(ctx.last_wait > 40 ? 4 : 30, 15 + i);
+	}
+	co_yield Burst(10, -1);
+}
+
+static void buildPrograms(Workload & workload)
+{
+	workload.num_of_processes = 2;
+	workload.setSwitchCosts(1, 4);
+	workload.addProgramThread(1, 1, 0, adaptive, 5);
+	workload.addProgramThread(1, 2, 2, adaptive, 3);
+	workload.addProgramThread(2, 1, 5, adaptive, 6);
+	int index = workload.addThread(2, 2, 1);
+	workload.addBurst(index, 50, 10);
+	workload.addBurst(index, 50, -1);
+}
+
+/*bursts spread over three io devices, some waiting for a busy device*/
+static void buildDevices(Workload & workload)
+{
+	uint64_t state = 11;
+
+	workload.num_of_processes = 3;
+	workload.setSwitchCosts(2, 5);
+	for (int p = 1; p <= 3; p++)
+	{
+		for (int t = 1; t <= 3; t++)
+		{
+			int index = workload.addThread(p, t, (p - 1) * 20 + t * 4);
+
+			for (int b = 0; b < 5; b++)
+			{
+				state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+				int cpu_t = 2 + (int)((state >> 33) % 30);
+				int io_t = 20 + (int)((state >> 17) % 90);
+				workload.addBurst(index, cpu_t, b == 4 ? -1 : io_t, (int)((state >> 45) % 3));
+			}
+		}
+	}
+}
+
+/*a linux scheduler trace with thread groups*/
+static void buildTrace(Workload & workload)
+{
+	std::ifstream in(TRACE_FILE, std::ios::binary);
+
+	importTrace(in, workload, TraceImportOptions());
+}
+
+static void configureFifoDevices(RunConfig & config)
+{
+	parseIODevices("fifo,fifo,fifo", config.io_devices);
+}
+
+static void configureParallelDevices(RunConfig & config)
+{
+	parseIODevices("2,fifo,inf", config.io_devices);
+}
+
+static void configureAffinity(RunConfig & config)
+{
+	config.affinity = SET;
+	config.warm_switch = 2;
+	config.cold_switch = 9;
+	config.migration_switch = 20;
+}
+
+/*benchmark workloads, large enough to run for a fraction of a second*/
+static void buildGeneratedLarge(Workload & workload)
+{
+	BurstDistribution cpu = { DIST_EXPONENTIAL, 25, 2 };
+	BurstDistribution io = { DIST_UNIFORM, 20, 400 };
+
+	workload.num_of_processes = 100;
+	workload.setSwitchCosts(3, 7);
+	for (int p = 1; p <= 100; p++)
+	{
+		for (int t = 1; t <= 4; t++)
+		{
+			workload.addGeneratedThread(p, t, p * 5 + t, BurstGenerator(cpu, io, p * 131 + t, 150));
+		}
+	}
+}
+
+static void buildBurstsLarge(Workload & workload)
+{
+	BurstDistribution cpu = { DIST_UNIFORM, 2, 60 };
+	BurstDistribution io = { DIST_UNIFORM, 10, 300 };
+
+	workload.num_of_processes = 100;
+	workload.setSwitchCosts(3, 7);
+	for (int p = 1; p <= 100; p++)
+	{
+		for (int t = 1; t <= 4; t++)
+		{
+			BurstGenerator generator(cpu, io, p * 7 + t, 150);
+			int index = workload.addThread(p, t, p * 5 + t);
+
+			while (generator.hasNext())
+			{
+				Burst burst = generator.next();
+				workload.addBurst(index, burst.get_cpu_time(), burst.get_io_time());
+			}
+		}
+	}
+}
+
+static void buildCompressedLarge(Workload & workload)
+{
+	buildBurstsLarge(workload);
+	for (int i = 0; i < workload.getNumberOfThreads(); i++)
+	{
+		workload.compressThread(i);
+	}
+}
+
+static const CorpusEntry corpus[] = {
+	{ "testcase1", "testcase1.txt", nullptr, nullptr },
+	{ "testcase3", "testcase3.txt", nullptr, nullptr },
+	{ "generated", nullptr, buildGenerated, nullptr },
+	{ "bursts", nullptr, buildBursts, nullptr },
+	{ "programs", nullptr, buildPrograms, nullptr },
+	{ "trace", nullptr, buildTrace, nullptr },
+	{ "devices-fifo", nullptr, buildDevices, configureFifoDevices },
+	{ "devices-parallel", nullptr, buildDevices, configureParallelDevices },
+	{ "affinity", "testcase3.txt", nullptr, configureAffinity },
+};
+
+static const Policy policies[] = {
+	{ "fcfs", NO_QUANTUM_VALUE },
+	{ "rr2", 2 },
+	{ "rr10", 10 },
+	{ "rr50", 50 },
+};
+
+static const Benchmark benchmarks[] = {
+	{ "bursts-fcfs", buildBurstsLarge, NO_QUANTUM_VALUE, 0 },
+	{ "bursts-rr10", buildBurstsLarge, 10, 0 },
+	{ "compressed-rr10", buildCompressedLarge, 10, 0 },
+	{ "generated-rr10", buildGeneratedLarge, 10, 0 },
+	{ "cluster16-rr10", buildGeneratedLarge, 10, 16 },
+};
+
+/*runs f with stdout sent to a temporary file and returns what it printed*/
+static std::string captureStdout(std::function<void()> f)
+{
+	std::string text;
+	FILE * capture = tmpfile();
+	int saved = dup(STDOUT_FILENO);
+
+	std::cout.flush();
+	fflush(stdout);
+	dup2(fileno(capture), STDOUT_FILENO);
+
+	f();
+
+	std::cout.flush();
+	fflush(stdout);
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+
+	rewind(capture);
+	char chunk[4096];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), capture)) > 0)
+	{
+		text.append(chunk, n);
+	}
+	fclose(capture);
+
+	return text;
+}
+
+/*reads or builds the workload of entry*/
+static bool loadEntry(const CorpusEntry & entry, Workload & workload, bool compress)
+{
+	workload.compress_bursts = compress;
+
+	if (entry.file != nullptr)
+	{
+		std::ifstream in(entry.file, std::ios::binary);
+		if (!in)
+		{
+			return false;
+		}
+		parseWorkload(in, workload);
+		return true;
+	}
+
+	entry.build(workload);
+	if (compress)
+	{
+		for (int i = 0; i < workload.getNumberOfThreads(); i++)
+		{
+			if (!workload.threads[i].bursts.empty())
+			{
+				workload.compressThread(i);
+			}
+		}
+	}
+	return true;
+}
+
+/*what simcpu -d -v prints for a single cpu run*/
+static std::string runSingle(const Workload & workload, const RunConfig & config)
+{
+	return captureStdout([&]()
+	{
+		CPUSim cpu;
+		cpu.configure(config);
+		cpu.load(workload);
+		stats_detailed(cpu.run());
+	});
+}
+
+static std::string runPlain(const CorpusEntry & entry, const RunConfig & config)
+{
+	Workload workload;
+	return loadEntry(entry, workload, false) ? runSingle(workload, config) : "";
+}
+
+static std::string runCompressed(const CorpusEntry & entry, const RunConfig & config)
+{
+	Workload workload;
+	return loadEntry(entry, workload, true) ? runSingle(workload, config) : "";
+}
+
+static std::string runMapped(const CorpusEntry & entry, const RunConfig & config)
+{
+	Workload workload;
+	return parseWorkloadFile(entry.file, workload, 4) >= 0 ? runSingle(workload, config) : "";
+}
+
+/*a cluster of one node has no verbose output but the statistics of a single cpu*/
+static std::string runOneNodeCluster(const CorpusEntry & entry, const RunConfig & config)
+{
+	Workload workload;
+	ClusterOptions options;
+
+	if (!loadEntry(entry, workload, false))
+	{
+		return "";
+	}
+	options.config = config;
+	options.policy = DISPATCH_LEAST_LOADED;
+	options.num_workers = 1;
+
+	return captureStdout([&]()
+	{
+		stats_detailed(runCluster(workload, options).totals);
+	});
+}
+
+static const Engine engines[] = {
+	{ "plain", false, true, runPlain },
+	{ "compressed", false, true, runCompressed },
+	{ "mapped", true, true, runMapped },
+	{ "cluster", false, false, runOneNodeCluster },
+};
+
+static bool readFile(const std::string & path, std::string & text)
+{
+	std::ifstream in(path, std::ios::binary);
+	std::ostringstream content;
+
+	if (!in)
+	{
+		return false;
+	}
+	content << in.rdbuf();
+	text = content.str();
+	return true;
+}
+
+static bool writeFile(const std::string & path, const std::string & text)
+{
+	std::ofstream out(path, std::ios::binary);
+	out << text;
+	return (bool)out;
+}
+
+/*testcase3 on 4 nodes, threads following their process where it ran last*/
+static std::string runAffinityCluster()
+{
+	Workload workload;
+	ClusterOptions options;
+
+	loadEntry(corpus[1], workload, false);
+	options.num_of_nodes = 4;
+	options.policy = DISPATCH_AFFINITY;
+	options.num_workers = 1;
+	options.config.round_robin = SET;
+	options.config.time_quantum = 10;
+	configureAffinity(options.config);
+
+	return captureStdout([&]()
+	{
+		printClusterStats(runCluster(workload, options), options, SET);
+	});
+}
+
+/*what --process-out writes for results*/
+static std::string processOut(const SimResults & results)
+{
+	std::string text;
+	char path[] = "/tmp/simharness-XXXXXX";
+	int fd = mkstemp(path);
+
+	if (fd < 0)
+	{
+		return "";
+	}
+	close(fd);
+	if (!writeProcessResults(path, results) || !readFile(path, text))
+	{
+		text = "";
+	}
+	unlink(path);
+	return text;
+}
+
+static std::string runProcessOut()
+{
+	Workload workload;
+	RunConfig config;
+	CPUSim cpu;
+
+	loadEntry(corpus[3], workload, false);
+	config.round_robin = SET;
+	config.time_quantum = 10;
+	cpu.configure(config);
+	cpu.load(workload);
+	return processOut(cpu.run());
+}
+
+/*threads of a process spread over nodes, their statistics add up per process*/
+static std::string runProcessOutCluster()
+{
+	Workload workload;
+	ClusterOptions options;
+
+	loadEntry(corpus[1], workload, false);
+	options.num_of_nodes = 4;
+	options.policy = DISPATCH_LEAST_LOADED;
+	options.num_workers = 1;
+	options.config.round_robin = SET;
+	options.config.time_quantum = 10;
+	return processOut(runCluster(workload, options).totals);
+}
+
+/*--log-out followed by a time range and a thread query, answered from the index*/
+static std::string runEventLog()
+{
+	Workload workload;
+	RunConfig config;
+	CPUSim cpu;
+	EventLog log;
+	EventLogReader reader;
+	char path[] = "/tmp/simharness-XXXXXX";
+	int fd = mkstemp(path);
+
+	if (fd < 0)
+	{
+		return "";
+	}
+	close(fd);
+
+	loadEntry(corpus[1], workload, false);
+	config.round_robin = SET;
+	config.time_quantum = 10;
+	cpu.configure(config);
+	cpu.load(workload);
+	if (!log.open(path))
+	{
+		unlink(path);
+		return "";
+	}
+	cpu.event_log = &log;
+	cpu.run();
+	bool written = log.close();
+
+	std::string text = captureStdout([&]()
+	{
+		if (!written || !reader.open(path))
+		{
+			printf("could not read the event log\n");
+			return;
+		}
+		printf("%lld events\n\nrange 2000 2400:\n", reader.getNumberOfEvents());
+		for (const Event & e : reader.queryRange(2000, 2400))
+		{
+			printEvent(e);
+		}
+		printf("\nthread 2 of process 3:\n");
+		for (const Event & e : reader.queryThread(3, 2))
+		{
+			printEvent(e);
+		}
+		reader.close();
+	});
+	unlink(path);
+	return text;
+}
+
+static const Scenario scenarios[] = {
+	{ "affinity-cluster4", runAffinityCluster },
+	{ "process-out", runProcessOut },
+	{ "process-out-cluster4", runProcessOutCluster },
+	{ "event-log", runEventLog },
+};
+
+/*golden output without the verbose transition lines*/
+static std::string statisticsOnly(const std::string & text)
+{
+	std::istringstream in(text);
+	std::string line;
+	std::string out;
+
+	while (std::getline(in, line))
+	{
+		if (line.compare(0, 8, "At Time ") != 0)
+		{
+			out += line + "\n";
+		}
+	}
+	return out;
+}
+
+/*prints the first line where actual differs from expected*/
+static void reportDifference(const std::string & expected, const std::string & actual)
+{
+	std::istringstream e(expected);
+	std::istringstream a(actual);
+	std::string le;
+	std::string la;
+	int line = 1;
+
+	while (true)
+	{
+		bool more_e = (bool)std::getline(e, le);
+		bool more_a = (bool)std::getline(a, la);
+
+		if (!more_e && !more_a)
+		{
+			return;
+		}
+		if (!more_e || !more_a || le != la)
+		{
+			printf("    line %d\n    expected: %s\n    actual:   %s\n", line,
+				more_e ? le.c_str() : "<end of output>", more_a ? la.c_str() : "<end of output>");
+			return;
+		}
+		line++;
+	}
+}
+
+/*returns the number of failures*/
+static int checkGolden(bool update)
+{
+	int failures = 0;
+
+	for (const CorpusEntry & entry : corpus)
+	{
+		for (const Policy & policy : policies)
+		{
+			RunConfig config;
+			std::string golden;
+			std::string path = std::string(GOLDEN_DIR) + entry.name + "-" + policy.name + ".txt";
+
+			config.verbose = SET;
+			config.detailed = SET;
+			config.round_robin = (policy.time_quantum != NO_QUANTUM_VALUE) ? SET : UNSET;
+			config.time_quantum = policy.time_quantum;
+			if (entry.configure != nullptr)
+			{
+				entry.configure(config);
+			}
+
+			if (update)
+			{
+				golden = engines[0].run(entry, config);
+				if (!writeFile(path, golden))
+				{
+					printf("FAIL %s: can not write\n", path.c_str());
+					failures++;
+					continue;
+				}
+			}
+			else if (!readFile(path, golden))
+			{
+				printf("FAIL %s: missing, run with --update to create it\n", path.c_str());
+				failures++;
+				continue;
+			}
+
+			for (const Engine & engine : engines)
+			{
+				if (engine.files_only && entry.file == nullptr)
+				{
+					continue;
+				}
+
+				std::string expected = engine.verbose ? golden : statisticsOnly(golden);
+				std::string actual = engine.run(entry, config);
+
+				if (actual == expected)
+				{
+					printf("ok   %s-%s %s\n", entry.name, policy.name, engine.name);
+				}
+				else
+				{
+					printf("FAIL %s-%s %s\n", entry.name, policy.name, engine.name);
+					reportDifference(expected, actual);
+					failures++;
+				}
+			}
+		}
+	}
+
+	for (const Scenario & scenario : scenarios)
+	{
+		std::string golden;
+		std::string path = std::string(GOLDEN_DIR) + scenario.name + ".txt";
+		std::string actual = scenario.run();
+
+		if (update)
+		{
+			if (!writeFile(path, actual))
+			{
+				printf("FAIL %s: can not write\n", path.c_str());
+				failures++;
+			}
+			continue;
+		}
+		if (!readFile(path, golden))
+		{
+			printf("FAIL %s: missing, run with --update to create it\n", path.c_str());
+			failures++;
+			continue;
+		}
+
+		if (actual == golden)
+		{
+			printf("ok   %s\n", scenario.name);
+		}
+		else
+		{
+			printf("FAIL %s\n", scenario.name);
+			reportDifference(golden, actual);
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+/*runs a benchmark in a child process so its peak memory is its own*/
+static bool measure(const Benchmark & benchmark, Measurement & m)
+{
+	int fds[2];
+	struct rusage usage;
+	int status;
+
+	if (pipe(fds) != 0)
+	{
+		return false;
+	}
+
+	pid_t child = fork();
+	if (child < 0)
+	{
+		return false;
+	}
+	if (child == 0)
+	{
+		Workload workload;
+		long long ticks = 0;
+
+		close(fds[0]);
+		benchmark.build(workload);
+
+		RunConfig config;
+		config.round_robin = (benchmark.time_quantum != NO_QUANTUM_VALUE) ? SET : UNSET;
+		config.time_quantum = benchmark.time_quantum;
+
+		auto begin = std::chrono::steady_clock::now();
+		if (benchmark.cluster_nodes > 0)
+		{
+			ClusterOptions options;
+			options.num_of_nodes = benchmark.cluster_nodes;
+			options.policy = DISPATCH_TWO_CHOICES;
+			options.config = config;
+			options.num_workers = 1;
+			for (const NodeResult & node : runCluster(workload, options).nodes)
+			{
+				ticks += node.total_time;
+			}
+		}
+		else
+		{
+			CPUSim cpu;
+			cpu.configure(config);
+			cpu.load(workload);
+			ticks = cpu.run().total_time;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		double ticks_per_s = ticks / seconds;
+		ssize_t written = write(fds[1], &ticks_per_s, sizeof(ticks_per_s));
+		_exit(written == sizeof(ticks_per_s) ? 0 : 1);
+	}
+
+	close(fds[1]);
+	bool ok = read(fds[0], &m.ticks_per_s, sizeof(m.ticks_per_s)) == sizeof(m.ticks_per_s);
+	close(fds[0]);
+
+	if (wait4(child, &status, 0, &usage) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		return false;
+	}
+	m.max_rss_kb = usage.ru_maxrss;
+	return ok;
+}
+
+/*returns the number of failures*/
+static int checkPerformance(bool update)
+{
+	std::map<std::string, Measurement> thresholds;
+	std::ifstream in(THRESHOLDS_FILE);
+	std::string line;
+	std::string updated = "# benchmark  min_ticks_per_s  max_rss_kb, written by simharness --update\n";
+	int failures = 0;
+
+	while (std::getline(in, line))
+	{
+		std::istringstream fields(line);
+		std::string name;
+		Measurement m;
+
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		if (fields >> name >> m.ticks_per_s >> m.max_rss_kb)
+		{
+			thresholds[name] = m;
+		}
+	}
+
+	for (const Benchmark & benchmark : benchmarks)
+	{
+		Measurement best = { 0, 0 };
+
+		for (int i = 0; i < BENCHMARK_REPEATS; i++)
+		{
+			Measurement m;
+			if (!measure(benchmark, m))
+			{
+				best.ticks_per_s = -1;
+				break;
+			}
+			best.ticks_per_s = std::max(best.ticks_per_s, m.ticks_per_s);
+			best.max_rss_kb = std::max(best.max_rss_kb, m.max_rss_kb);
+		}
+
+		if (best.ticks_per_s < 0)
+		{
+			printf("FAIL %s: benchmark did not complete\n", benchmark.name);
+			failures++;
+			continue;
+		}
+
+		if (update)
+		{
+			char entry[256];
+			snprintf(entry, sizeof(entry), "%s %.0f %ld\n", benchmark.name,
+				best.ticks_per_s * THRESHOLD_SPEED_MARGIN, (long)(best.max_rss_kb * THRESHOLD_MEMORY_MARGIN));
+			updated += entry;
+			printf("set  %s: %.0f ticks/s, %ld KB\n", benchmark.name, best.ticks_per_s, best.max_rss_kb);
+			continue;
+		}
+
+		auto found = thresholds.find(benchmark.name);
+		if (found == thresholds.end())
+		{
+			printf("FAIL %s: no threshold, run with --update to create it\n", benchmark.name);
+			failures++;
+			continue;
+		}
+
+		bool fast_enough = best.ticks_per_s >= found->second.ticks_per_s;
+		bool small_enough = best.max_rss_kb <= found->second.max_rss_kb;
+		printf("%s %s: %.0f ticks/s (min %.0f), %ld KB (max %ld)\n", (fast_enough && small_enough) ? "ok  " : "FAIL",
+			benchmark.name, best.ticks_per_s, found->second.ticks_per_s, best.max_rss_kb, found->second.max_rss_kb);
+		if (!fast_enough || !small_enough)
+		{
+			failures++;
+		}
+	}
+
+	if (update && !writeFile(THRESHOLDS_FILE, updated))
+	{
+		printf("FAIL %s: can not write\n", THRESHOLDS_FILE);
+		failures++;
+	}
+
+	return failures;
+}
+
+int main(int argc, char ** argv)
+{
+	bool update = false;
+	bool golden = true;
+	bool performance = true;
+	int failures = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--update") == 0)
+		{
+			update = true;
+		}
+		else if (strcmp(argv[i], "--golden-only") == 0)
+		{
+			performance = false;
+		}
+		else if (strcmp(argv[i], "--perf-only") == 0)
+		{
+			golden = false;
+		}
+		else
+		{
+			printf("usage: %s [--update] [--golden-only | --perf-only]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	/*benchmarks go first, children forked after the golden runs inherit their heap and run slower*/
+	if (performance)
+	{
+		failures += checkPerformance(update);
+	}
+	if (golden)
+	{
+		failures += checkGolden(update);
+	}
+
+	printf("%s, %d failure%s\n", failures == 0 ? "PASS" : "FAIL", failures, failures == 1 ? "" : "s");
+	return failures == 0 ? 0 : 1;
+}
@@ -1,55 +1,269 @@
+#include "AutoTune.h"
+#include "Cluster.h"
 #include "CPUSim.h"
+#include "EventLog.h"
+#include "ResultCache.h"
+#include "ResultsWriter.h"
+#include "Sampler.h"
+#include "SimServer.h"
+#include "TraceImport.h"
+#include "WorkloadFile.h"
+#include <fstream>
+#include <string.h>
 
 int main(int argc, char ** argv)
 {
 	//freopen("testcase3.txt", "r+", stdin);
 
 	CPUSim cpu;
-	SimQueue exit_queue;
+	CommandLine cmd;
+	Workload workload;
+	ResultsWriter results;
+	Sampler sampler;
+	EventLog event_log;
 
-	processCommandLineArgs(cpu, argv, argc); /*sets flags and/or time quantum*/
+	processCommandLineArgs(cmd, argv, argc); /*sets flags and/or time quantum*/
+	cpu.configure(cmd.config);
 
-	initializeJobQueue(cpu);
+	if (cmd.serve_path != nullptr)
+	{
+		/*stay resident and answer run requests, --workload is preloaded as "default"*/
+		SimServer server(cmd.jobs);
 
-	while (cpu.canContinue(exit_queue)) /*if there are still threads to be worked on continue*/
+		if (cmd.workload_file != nullptr && !server.loadWorkload("default", cmd.workload_file))
+		{
+			printf("Could not parse workload %s. Exiting.\n", cmd.workload_file);
+			exit(0);
+		}
+		int served = server.serve(cmd.serve_path);
+		if (served == -2)
+		{
+			printf("%s exists and is not a socket. Exiting.\n", cmd.serve_path);
+		}
+		else if (served < 0)
+		{
+			printf("Could not listen on %s. Exiting.\n", cmd.serve_path);
+		}
+		return 0;
+	}
+
+	if (cmd.log_query != nullptr)
+	{
+		/*answer a query on the event log of an earlier run, only the blocks it needs are read*/
+		EventLogReader reader;
+
+		if (!reader.open(cmd.log_query))
+		{
+			printf("Could not read event log %s. Exiting.\n", cmd.log_query);
+			exit(0);
+		}
+		std::vector<Event> events = cmd.query_range ? reader.queryRange(cmd.range_start, cmd.range_end)
+			: reader.queryThread(cmd.query_process, cmd.query_thread);
+		for (const Event & e : events)
+		{
+			printEvent(e);
+		}
+		return 0;
+	}
+
+	if (cmd.trace_file != nullptr)
+	{
+		/*replay a linux scheduler trace instead of reading a workload from stdin*/
+		std::ifstream trace(cmd.trace_file, std::ios::binary);
+		TraceImportOptions options;
+
+		if (!trace)
+		{
+			printf("Could not open trace %s. Exiting.\n", cmd.trace_file);
+			exit(0);
+		}
+		options.compress_bursts = cmd.compress_bursts;
+		if (cmd.trace_unit_ns > 0)
+		{
+			options.time_unit_ns = cmd.trace_unit_ns;
+		}
+		if (importTrace(trace, workload, options) < 0)
+		{
+			printf("Trace %s is too long for a time unit of %lld ns. Exiting.\n", cmd.trace_file, options.time_unit_ns);
+			exit(0);
+		}
+	}
+	else if (cmd.workload_file != nullptr)
 	{
-		switch (cpu.mode)
+		/*large workload files are memory mapped and parsed on all cores*/
+		workload.compress_bursts = cmd.compress_bursts;
+		if (parseWorkloadFile(cmd.workload_file, workload, cmd.jobs) < 0)
 		{
-		case NEWCPU: /*CPU in NEWCPU upon initialization*/
-			cpu.setMode(DISPATCHING);
-			break;
-		case DISPATCHING:
-			/*if cpu dispatching, get the next thread to execute,
-			this function auto switches to either PSWITCH or
-			TSWITCH cpu mode based on the circumstanses*/
-			cpu.getNextThread();
-			break;
-		case EXECUTING:
-			/*executes a burst or loads in a new one if there is not one executing*/
-			/*function auto switches to dispatching once a thread is done its burst*/
-			cpu.executeThread(exit_queue);
-			break;
-		case PSWITCH:
-		case TSWITCH:
-			/*check to see when we can exit the context switch and begin executing*/
-			cpu.checkStatus();
-			break;
-		default:
-			printf("Fatal Error. Exiting\n");
+			printf("Could not parse workload %s. Exiting.\n", cmd.workload_file);
 			exit(0);
 		}
+	}
+	else
+	{
+		workload.compress_bursts = cmd.compress_bursts;
+		parseWorkload(std::cin, workload);
+	}
+
+	if (cmd.autotune != nullptr)
+	{
+		/*search the RR quantum space instead of doing a single run*/
+		TuneOptions options;
+		options.objective = (strcmp(cmd.autotune, "p99") == 0) ? TUNE_P99 : TUNE_AVERAGE;
+		if (cmd.tune_min > 0)
+		{
+			options.min_quantum = cmd.tune_min;
+		}
+		options.max_quantum = cmd.tune_max;
+		options.num_workers = cmd.jobs;
 
-		/*move any arriving threads into ready queue*/
-		cpu.addArrivingIOThreadsToReadyQueue();
-		/*move any finished IO threads to ready queue*/
-		cpu.addFinishedIOThreadsToReadyQueue();
+		printTuneResult(autotune(workload, options), options.objective);
+		return 0;
+	}
+
+	if (cmd.cluster_nodes > 0)
+	{
+		/*simulate a cluster of nodes behind a dispatcher instead of a single cpu*/
+		ClusterOptions options;
+		options.num_of_nodes = cmd.cluster_nodes;
+		options.config = cmd.config;
+		options.num_workers = cmd.jobs;
+		if (cmd.dispatch != nullptr && strcmp(cmd.dispatch, "least") == 0)
+		{
+			options.policy = DISPATCH_LEAST_LOADED;
+		}
+		else if (cmd.dispatch != nullptr && strcmp(cmd.dispatch, "p2c") == 0)
+		{
+			options.policy = DISPATCH_TWO_CHOICES;
+		}
+		else if (cmd.dispatch != nullptr && strcmp(cmd.dispatch, "affinity") == 0)
+		{
+			options.policy = DISPATCH_AFFINITY;
+		}
+
+		ClusterResults cluster = runCluster(workload, options);
+
+		if (cmd.results_file != nullptr)
+		{
+			/*the nodes run concurrently and their exits are only merged into one order once
+			the cluster has finished, so the rows are written afterwards, not as threads exit*/
+			if (!results.open(cmd.results_file, resultsFormatForPath(cmd.results_file)))
+			{
+				printf("Could not create %s. Exiting.\n", cmd.results_file);
+				exit(0);
+			}
+			for (const ThreadResult & r : cluster.totals.threads)
+			{
+				results.addThread(r);
+			}
+			if (!results.close())
+			{
+				printf("Could not write %s. Exiting.\n", cmd.results_file);
+				exit(0);
+			}
+		}
 
-		/*clock tick*/
-		cpu.advanceClock();
+		if (cmd.process_file != nullptr && !writeProcessResults(cmd.process_file, cluster.totals))
+		{
+			printf("Could not create %s. Exiting.\n", cmd.process_file);
+			exit(0);
+		}
+
+		printClusterStats(cluster, options, cmd.config.detailed);
+		return 0;
+	}
+
+	if (cmd.results_file != nullptr)
+	{
+		/*threads are written to the results file as they exit*/
+		if (!results.open(cmd.results_file, resultsFormatForPath(cmd.results_file)))
+		{
+			printf("Could not create %s. Exiting.\n", cmd.results_file);
+			exit(0);
+		}
+		cpu.results_out = &results;
+	}
+
+	if (cmd.sample_file != nullptr)
+	{
+		/*utilization and queue depths are sampled every sample_interval time units*/
+		if (!sampler.open(cmd.sample_file, resultsFormatForPath(cmd.sample_file), cmd.sample_interval))
+		{
+			printf("Could not create %s. Exiting.\n", cmd.sample_file);
+			exit(0);
+		}
+		cpu.setSampler(&sampler);
+	}
+
+	if (cmd.log_file != nullptr)
+	{
+		/*state transitions are written to the event log by a background thread*/
+		if (!event_log.open(cmd.log_file))
+		{
+			printf("Could not create %s. Exiting.\n", cmd.log_file);
+			exit(0);
+		}
+		cpu.event_log = &event_log;
+	}
+
+	/*verbose output, samples, process, device and switch statistics and event logs only come from a real run, so those runs are never cached*/
+	uint64_t key = 0;
+	SimResults stats;
+	if (cmd.cache_dir != nullptr && cmd.config.verbose == UNSET && cmd.sample_file == nullptr && cmd.process_file == nullptr
+		&& cmd.log_file == nullptr && cmd.config.io_devices.empty()
+		&& cmd.config.affinity == UNSET)
+	{
+		key = resultKey(workload, cmd.config);
+	}
+
+	if (key != 0 && ResultCache(cmd.cache_dir).lookup(key, stats))
+	{
+		/*cache hit, the per thread rows are replayed in exit order*/
+		for (const ThreadResult & r : stats.threads)
+		{
+			results.addThread(r);
+		}
+	}
+	else
+	{
+		/*the workload is only loaded into the cpu when it has to be simulated*/
+		cpu.load(workload);
+		stats = cpu.run(); /*steps the cpu until all threads have exited*/
+
+		if (key != 0)
+		{
+			ResultCache(cmd.cache_dir).store(key, stats);
+		}
+	}
+
+	if (cmd.process_file != nullptr && !writeProcessResults(cmd.process_file, stats))
+	{
+		printf("Could not create %s. Exiting.\n", cmd.process_file);
+		exit(0);
+	}
+
+	if (cmd.log_file != nullptr && !event_log.close())
+	{
+		printf("Could not write %s. Exiting.\n", cmd.log_file);
+		exit(0);
+	}
+
+	if (cmd.results_file != nullptr && !results.close())
+	{
+		printf("Could not write %s. Exiting.\n", cmd.results_file);
+		exit(0);
+	}
+
+	/*once all threads exit we display stats*/
+	if (cmd.config.detailed == SET)
+	{
+		stats_detailed(stats);
+	}
+	else
+	{
+		stats_default(stats);
 	}
 
-	/*once all threads exit we calculate and display stats*/
-	cpu.calculateStatistics(exit_queue);
+	sampler.close();
 
 	return 0;
 }